@@ -0,0 +1,197 @@
+// Copyright (c) 2024 NextGenium
+
+// Standalone micro-benchmark of lock-on target selection, it only needs TargetSystemCore.h and a C++17 compiler:
+//   g++ -O2 -std=c++17 -I../Source/TargetSystem/Public TargetSystemCoreBenchmark.cpp -o TargetSystemCoreBenchmark
+// It compares TargetSystemCore::FindNearestTargetWithPolicy with the selection FindNearestTarget used before it, which
+// sorted every candidate by distance, then sorted a copy by angle, reading positions through the target interface on
+// every comparison. Both must pick the same target, the benchmark fails otherwise.
+
+#include "TargetSystemCore.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct FVec
+	{
+		double X = 0.0, Y = 0.0, Z = 0.0;
+	};
+
+	// Stands in for ITargetSystemInterface -> UTargetSystemDependencies -> AActor, two hops per location read
+	struct FOwner
+	{
+		FVec Location;
+	};
+
+	struct ITarget
+	{
+		virtual ~ITarget() = default;
+		virtual const FOwner* GetOwner() const = 0;
+
+		// Position in FScenario::Targets, the engine code kept interfaces and needed no lookup
+		int Index = -1;
+	};
+
+	struct FTarget final : ITarget
+	{
+		explicit FTarget(const FOwner* InOwner) : Owner(InOwner) {}
+		virtual const FOwner* GetOwner() const override { return Owner; }
+		const FOwner* Owner;
+	};
+
+	struct FScenario
+	{
+		std::vector<std::unique_ptr<FOwner>> Owners;
+		std::vector<std::unique_ptr<ITarget>> Targets;
+		std::vector<bool> bInViewport;
+		std::vector<bool> bVisible;
+		FVec Player;
+		double ViewYaw = 0.0;
+		TargetSystemCore::FNearestTargetParams Params;
+	};
+
+	float GetDistance(const FScenario& Scenario, const ITarget& Target)
+	{
+		const FVec& Location = Target.GetOwner()->Location;
+		const double X = Location.X - Scenario.Player.X, Y = Location.Y - Scenario.Player.Y, Z = Location.Z - Scenario.Player.Z;
+		return static_cast<float>(std::sqrt(X * X + Y * Y + Z * Z));
+	}
+
+	float GetAngle(const FScenario& Scenario, const ITarget& Target)
+	{
+		const FVec& Location = Target.GetOwner()->Location;
+		return TargetSystemCore::GetYawAngle(Scenario.ViewYaw, Location.X - Scenario.Player.X, Location.Y - Scenario.Player.Y);
+	}
+
+	FScenario MakeScenario(const int NumCandidates, std::mt19937& Random)
+	{
+		std::uniform_real_distribution<double> Coordinate(-4000.0, 4000.0);
+		std::uniform_int_distribution<int> Percent(0, 99);
+
+		FScenario Scenario;
+		Scenario.Params.MaximumDistance = 3000.f;
+		Scenario.Params.DangerousDistance = 500.f;
+		Scenario.Params.MaximumAngle = 50.f;
+		Scenario.Params.ExtraDistanceByAngle = 400.f;
+		Scenario.ViewYaw = std::uniform_real_distribution<double>(0.0, 360.0)(Random);
+
+		for (int i = 0; i < NumCandidates; ++i)
+		{
+			Scenario.Owners.push_back(std::make_unique<FOwner>(FOwner{{Coordinate(Random), Coordinate(Random), Coordinate(Random) * 0.05}}));
+			Scenario.Targets.push_back(std::make_unique<FTarget>(Scenario.Owners.back().get()));
+			Scenario.Targets.back()->Index = i;
+			Scenario.bInViewport.push_back(Percent(Random) < 40);
+			Scenario.bVisible.push_back(Percent(Random) < 80);
+		}
+		return Scenario;
+	}
+
+	// FindNearestTarget(true) before the heap selection, line of sight is counted as it is a trace in the engine
+	int FindNearestTargetBySort(const FScenario& Scenario, int& OutLineOfSightChecks)
+	{
+		std::vector<const ITarget*> Sorted;
+		for (const std::unique_ptr<ITarget>& Target : Scenario.Targets) Sorted.push_back(Target.get());
+		std::sort(Sorted.begin(), Sorted.end(), [&Scenario](const ITarget* A, const ITarget* B)
+		{
+			return GetDistance(Scenario, *A) < GetDistance(Scenario, *B);
+		});
+
+		std::vector<const ITarget*> ByAngle;
+		const ITarget* Nearest = nullptr;
+		for (const ITarget* Target : Sorted)
+		{
+			const int Index = Target->Index;
+			++OutLineOfSightChecks;
+			if (!Scenario.bVisible[Index]) continue;
+
+			const float Distance = GetDistance(Scenario, *Target);
+			if (Distance > Scenario.Params.MaximumDistance) continue;
+			if (!Scenario.bInViewport[Index] && Distance > Scenario.Params.DangerousDistance) continue;
+
+			if (!Nearest) Nearest = Target;
+			ByAngle.push_back(Target);
+		}
+		if (!Nearest) return -1;
+
+		std::sort(ByAngle.begin(), ByAngle.end(), [&Scenario](const ITarget* A, const ITarget* B)
+		{
+			return GetAngle(Scenario, *A) < GetAngle(Scenario, *B);
+		});
+		for (const ITarget* Target : ByAngle)
+		{
+			if (GetAngle(Scenario, *Target) > Scenario.Params.MaximumAngle) continue;
+			if (GetDistance(Scenario, *Nearest) + Scenario.Params.ExtraDistanceByAngle < GetDistance(Scenario, *Target)) continue;
+			return Target->Index;
+		}
+		return Nearest->Index;
+	}
+
+	int FindNearestTargetByHeap(const FScenario& Scenario, std::vector<TargetSystemCore::FTargetCandidate>& Candidates, int& OutLineOfSightChecks)
+	{
+		Candidates.clear();
+		for (size_t i = 0; i < Scenario.Targets.size(); ++i)
+		{
+			Candidates.push_back({static_cast<int>(i), GetDistance(Scenario, *Scenario.Targets[i])});
+		}
+
+		return TargetSystemCore::FindNearestTargetWithPolicy<TargetSystemCore::NearestPolicy_DistanceAngle>(
+			Candidates.data(), static_cast<int>(Candidates.size()), Scenario.Params,
+			[&Scenario](const int i) { return static_cast<bool>(Scenario.bInViewport[i]); },
+			[&Scenario, &OutLineOfSightChecks](const int i) { ++OutLineOfSightChecks; return static_cast<bool>(Scenario.bVisible[i]); },
+			[&Scenario](const int i) { return GetAngle(Scenario, *Scenario.Targets[i]); });
+	}
+
+	template <typename FSelect>
+	double MeasureMicroseconds(const std::vector<FScenario>& Scenarios, const int Iterations, FSelect&& Select)
+	{
+		const auto Start = std::chrono::steady_clock::now();
+		for (int Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			for (const FScenario& Scenario : Scenarios)
+			{
+				Select(Scenario);
+			}
+		}
+		const std::chrono::duration<double, std::micro> Elapsed = std::chrono::steady_clock::now() - Start;
+		return Elapsed.count() / (static_cast<double>(Iterations) * Scenarios.size());
+	}
+}
+
+int main()
+{
+	constexpr int NumScenarios = 64;
+	std::mt19937 Random(7);
+
+	std::printf("%10s %14s %14s %8s %16s %16s\n", "Candidates", "Sort (us)", "Heap (us)", "Speedup", "Sort LOS checks", "Heap LOS checks");
+	for (const int NumCandidates : {10, 100, 1000})
+	{
+		std::vector<FScenario> Scenarios;
+		for (int i = 0; i < NumScenarios; ++i) Scenarios.push_back(MakeScenario(NumCandidates, Random));
+
+		std::vector<TargetSystemCore::FTargetCandidate> Candidates;
+		int SortChecks = 0, HeapChecks = 0;
+		for (const FScenario& Scenario : Scenarios)
+		{
+			const int BySort = FindNearestTargetBySort(Scenario, SortChecks);
+			const int ByHeap = FindNearestTargetByHeap(Scenario, Candidates, HeapChecks);
+			if (BySort != ByHeap)
+			{
+				std::printf("Selections differ at %d candidates: %d by sort, %d by heap\n", NumCandidates, BySort, ByHeap);
+				return 1;
+			}
+		}
+
+		const int Iterations = NumCandidates >= 1000 ? 20 : NumCandidates >= 100 ? 200 : 2000;
+		int Unused = 0;
+		const double SortUs = MeasureMicroseconds(Scenarios, Iterations, [&Unused](const FScenario& Scenario) { return FindNearestTargetBySort(Scenario, Unused); });
+		const double HeapUs = MeasureMicroseconds(Scenarios, Iterations, [&Unused, &Candidates](const FScenario& Scenario) { return FindNearestTargetByHeap(Scenario, Candidates, Unused); });
+
+		std::printf("%10d %14.2f %14.2f %7.1fx %16.1f %16.1f\n", NumCandidates, SortUs, HeapUs, SortUs / HeapUs,
+			static_cast<double>(SortChecks) / NumScenarios, static_cast<double>(HeapChecks) / NumScenarios);
+	}
+	return 0;
+}
@@ -3,38 +3,45 @@
 
 #include "NextTargetSystemComponent.h"
 
+#include "TargetSystemStats.h"
 #include "TST_TargetLock.h"
 #include "TargetingSystem/TargetingPreset.h"
 #include "TargetingSystem/TargetingSubsystem.h"
+#include "GameFramework/PlayerController.h"
 #include "Types/TargetingSystemTypes.h"
 
 void UNextTargetSystemComponent::TryStartTargetLock()
 {
 	if (bUseTargetSubsystem)
 	{
+		TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_TargetingRequest);
+		TARGETSYSTEM_TRACE_OBJECT_SCOPE(GetOwner());
+
 		if (!IsValid(TargetingPreset))
 		{
+			MessageFinishTargetLock();
+			return;
+		}
+
+		// Lock requests repeated within a frame are served by the one already in flight
+		if (LockRequestFrame == GFrameCounter && TargetingHandles.Contains(LockRequestHandle))
+		{
+			INC_DWORD_STAT(STAT_TargetSystemCoalescedLockRequests);
 			return;
 		}
 		
-		ClearTargetingHandles();
-		
-		FTargetingSourceContext SourceContext;
-		SourceContext.SourceActor = GetOwner();
-		UTargetLockContext* TargetLockContext = NewObject<UTargetLockContext>(this);
-		SourceContext.SourceObject = TargetLockContext;
-		const FTargetingRequestHandle TargetingHandle =
-				UTargetingSubsystem::MakeTargetRequestHandle(
-					TargetingPreset,
-					SourceContext);
+		CancelTargetingRequests();
+
+		const FTargetingRequestHandle TargetingHandle = MakeTargetingRequest(ETargetSwitchMode::LockOn, nullptr);
 		const FTargetingRequestDelegate Delegate = FTargetingRequestDelegate::CreateUObject(
 			this,
 			&UNextTargetSystemComponent::OnTargetingCompleted);
 
+		LockRequestHandle = TargetingHandle;
+		LockRequestFrame = GFrameCounter;
 		UTargetingSubsystem::Get(GetWorld())->StartAsyncTargetingRequestWithHandle(
 					TargetingHandle,
 					Delegate);
-		TargetingHandles.Add(TargetingHandle);
 	}
 	else
 	{
@@ -46,22 +53,24 @@ void UNextTargetSystemComponent::SwitchTarget(FVector2D AxisValue)
 {
 	if (bUseTargetSubsystem)
 	{
+		TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_TargetingRequest);
+		TARGETSYSTEM_TRACE_OBJECT_SCOPE(GetOwner());
+
 		if (!CanSwitchTarget(AxisValue)) return;
 		if (bIsSwitchingTarget) return;
+		if (TrySwitchToPrecomputedTarget(AxisValue)) return;
 		
-		ClearTargetingHandles();
-		
-		FTargetingSourceContext SourceContext;
-		SourceContext.SourceActor = GetOwner();
-		UTargetLockContext* TargetLockContext = NewObject<UTargetLockContext>(this);
-		TargetLockContext->CurrentTarget = Cast<AActor>(NearestTarget.GetObject());
-		TargetLockContext->Mode = AxisValue.X > 0.f ? ETargetSwitchMode::SwitchRight : ETargetSwitchMode::SwitchLeft;
-		SourceContext.SourceObject = TargetLockContext;
-
-		const FTargetingRequestHandle TargetingHandle = UTargetingSubsystem::MakeTargetRequestHandle(TargetingPreset, SourceContext);
+		CancelTargetingRequests();
+
+		const FTargetingRequestHandle TargetingHandle = MakeTargetingRequest(
+			AxisValue.X > 0.f ? ETargetSwitchMode::SwitchRight : ETargetSwitchMode::SwitchLeft,
+			Cast<AActor>(NearestTarget.GetObject()));
 		FTargetingRequestDelegate Delegate;
 		Delegate.BindLambda([this](const FTargetingRequestHandle& TargetingHandle)
 		{
+			TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_TargetingCompleted);
+			if (!FinishTargetingRequest(TargetingHandle)) return;
+
 			TArray<AActor*> ActorsToLook;
 			UTargetingSubsystem::Get(GetWorld())->GetTargetingResultsActors(TargetingHandle, ActorsToLook);
 			for (AActor* Actor : ActorsToLook)
@@ -77,7 +86,6 @@ void UNextTargetSystemComponent::SwitchTarget(FVector2D AxisValue)
 				}
 			}
 		});
-		TargetingHandles.Add(TargetingHandle);
 		
 		UTargetingSubsystem::Get(GetWorld())->ExecuteTargetingRequestWithHandle(TargetingHandle, Delegate);
 	}
@@ -103,12 +111,23 @@ void UNextTargetSystemComponent::AutoSwitchTarget()
 void UNextTargetSystemComponent::StopObservingTarget(
 	const bool bIgnoreAutoSwitch, const bool bTargetIsDead)
 {
-	ClearTargetingHandles();
+	CancelTargetingRequests();
 	Super::StopObservingTarget(bIgnoreAutoSwitch, bTargetIsDead);
 }
 
+void UNextTargetSystemComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	CancelTargetingRequests();
+	ReleaseDeferredTargetingHandles(true);
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void UNextTargetSystemComponent::OnTargetingCompleted(FTargetingRequestHandle Handle)
 {
+	TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_TargetingCompleted);
+	if (!FinishTargetingRequest(Handle)) return;
+
 	TArray<AActor*> ActorsToLook;
 	UTargetingSubsystem::Get(GetWorld())->GetTargetingResultsActors(Handle, ActorsToLook);
 	for (AActor* Actor : ActorsToLook)
@@ -134,10 +153,191 @@ void UNextTargetSystemComponent::OnTargetingCompleted(FTargetingRequestHandle Ha
 	StartObservingTarget();
 }
 
-void UNextTargetSystemComponent::ClearTargetingHandles()
+void UNextTargetSystemComponent::UpdateSwitchSlots()
+{
+	if (!bUseTargetSubsystem)
+	{
+		Super::UpdateSwitchSlots();
+		return;
+	}
+
+	// One side per request, the next one starts once the previous completed
+	if (!IsValid(TargetingPreset) || SwitchSlotRequestHandle.IsValid()) return;
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (Now < NextSwitchSlotRequestTime) return;
+
+	TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_UpdateSwitchSlots);
+
+	const ETargetSwitchMode Mode = bNextSwitchSlotRight ? ETargetSwitchMode::SwitchRight : ETargetSwitchMode::SwitchLeft;
+	bNextSwitchSlotRight = !bNextSwitchSlotRight;
+	NextSwitchSlotRequestTime = Now + SwitchSlotRefreshInterval;
+
+	SwitchSlotRequestHandle = MakeTargetingRequest(Mode, GetLockedOnTargetActor());
+	UTargetingSubsystem::Get(GetWorld())->StartAsyncTargetingRequestWithHandle(
+		SwitchSlotRequestHandle,
+		FTargetingRequestDelegate::CreateUObject(this, &UNextTargetSystemComponent::OnSwitchSlotRequestCompleted, Mode));
+}
+
+void UNextTargetSystemComponent::ResetSwitchSlots()
+{
+	Super::ResetSwitchSlots();
+
+	if (SwitchSlotRequestHandle.IsValid())
+	{
+		CancelTargetingRequest(SwitchSlotRequestHandle);
+	}
+	for (TWeakObjectPtr<AActor>& PrecomputedSwitchTarget : PrecomputedSwitchTargets)
+	{
+		PrecomputedSwitchTarget.Reset();
+	}
+	NextSwitchSlotRequestTime = 0.0;
+}
+
+TScriptInterface<ITargetSystemInterface> UNextTargetSystemComponent::FindPrecomputedSwitchTarget(const FVector2D& AxisValue)
+{
+	if (!bUseTargetSubsystem) return Super::FindPrecomputedSwitchTarget(AxisValue);
+
+	// Same side as the mode SwitchTarget requests
+	const bool bRight = AxisValue.X > 0.f;
+	AActor* TargetActor = PrecomputedSwitchTargets[bRight].Get();
+	if (!IsValid(TargetActor) || TargetActor == GetLockedOnTargetActor()) return nullptr;
+
+	const TargetInterface Target(TargetActor);
+	if (!ObjectIsTargetable(Target)) return nullptr;
+
+	// Revalidated with the screen side check of UTFT_SwitchTargetLock against the current view, not with the yaw based
+	// IsValidSwitchTarget of the legacy search, which rejects targets the preset ranked on screen position
+	const FTargetSystemViewSnapshot View = CaptureRequestViewSnapshot();
+	if (!View.HasPlayerController()) return Target;
+
+	FVector2D ScreenPosition;
+	View.ProjectWorldToScreen(TargetActor->GetActorLocation(), ScreenPosition);
+	return TargetSystemCore::IsOppositeToSwitch(ScreenPosition.X, View.GetViewportCenter().X, !bRight) ? nullptr : Target;
+}
+
+void UNextTargetSystemComponent::OnSwitchSlotRequestCompleted(FTargetingRequestHandle Handle, const ETargetSwitchMode Mode)
+{
+	TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_TargetingCompleted);
+	if (!FinishTargetingRequest(Handle)) return;
+
+	if (Handle.Handle != SwitchSlotRequestHandle.Handle) return;
+	SwitchSlotRequestHandle.Reset();
+
+	TArray<AActor*> ActorsToLook;
+	UTargetingSubsystem::Get(GetWorld())->GetTargetingResultsActors(Handle, ActorsToLook);
+
+	AActor* const* Best = ActorsToLook.FindByPredicate([](const AActor* Actor) { return IsValid(Actor); });
+	PrecomputedSwitchTargets[Mode == ETargetSwitchMode::SwitchRight] = Best ? *Best : nullptr;
+}
+
+UTargetLockContext* UNextTargetSystemComponent::AcquireLockContext(const ETargetSwitchMode Mode, AActor* CurrentTarget)
+{
+	UTargetLockContext* TargetLockContext = nullptr;
+	if (!FreeLockContexts.IsEmpty())
+	{
+		TargetLockContext = FreeLockContexts.Pop();
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_TargetSystemLockContextAllocations);
+		TargetLockContext = NewObject<UTargetLockContext>(this);
+		LockContextPool.Add(TargetLockContext);
+	}
+
+	TargetLockContext->Mode = Mode;
+	TargetLockContext->CurrentTarget = CurrentTarget;
+	TargetLockContext->SetViewSnapshot(CaptureRequestViewSnapshot());
+	return TargetLockContext;
+}
+
+void UNextTargetSystemComponent::ReleaseLockContext(const FTargetingRequestHandle& Handle)
+{
+	const FTargetingSourceContext* SourceContext = FTargetingSourceContext::Find(Handle);
+	UTargetLockContext* TargetLockContext = SourceContext ? Cast<UTargetLockContext>(SourceContext->SourceObject) : nullptr;
+	if (!TargetLockContext || !LockContextPool.Contains(TargetLockContext)) return;
+
+	TargetLockContext->Reset();
+	FreeLockContexts.AddUnique(TargetLockContext);
+}
+
+FTargetSystemViewSnapshot UNextTargetSystemComponent::CaptureRequestViewSnapshot() const
+{
+	const APawn* Pawn = Cast<APawn>(GetOwner());
+	return FTargetSystemViewSnapshot::Capture(Pawn, Pawn ? Cast<APlayerController>(Pawn->GetController()) : nullptr);
+}
+
+FTargetingRequestHandle UNextTargetSystemComponent::MakeTargetingRequest(const ETargetSwitchMode Mode, AActor* CurrentTarget)
+{
+	// Nothing reads the results of completed requests anymore once a new one starts
+	ReleaseDeferredTargetingHandles(false);
+
+	FTargetingSourceContext SourceContext;
+	SourceContext.SourceActor = GetOwner();
+	SourceContext.SourceObject = AcquireLockContext(Mode, CurrentTarget);
+
+	const FTargetingRequestHandle TargetingHandle = UTargetingSubsystem::MakeTargetRequestHandle(TargetingPreset, SourceContext);
+	TargetingHandles.Add(TargetingHandle);
+	INC_DWORD_STAT(STAT_TargetSystemActiveTargetingRequests);
+	return TargetingHandle;
+}
+
+bool UNextTargetSystemComponent::FinishTargetingRequest(const FTargetingRequestHandle& Handle)
+{
+	// Results of cancelled requests are ignored
+	if (TargetingHandles.RemoveSwap(Handle) == 0) return false;
+
+	DEC_DWORD_STAT(STAT_TargetSystemActiveTargetingRequests);
+	ReleaseLockContext(Handle);
+
+	// The subsystem may still use the handle after this callback
+	DeferTargetingHandleRelease(Handle);
+	return true;
+}
+
+void UNextTargetSystemComponent::CancelTargetingRequest(FTargetingRequestHandle Handle)
+{
+	if (TargetingHandles.RemoveSwap(Handle) == 0) return;
+
+	if (UTargetingSubsystem* TargetingSubsystem = UTargetingSubsystem::Get(GetWorld()))
+	{
+		TargetingSubsystem->RemoveAsyncTargetingRequestWithHandle(Handle);
+	}
+	ReleaseLockContext(Handle);
+
+	// Cancellation may happen inside the subsystem's tick, e.g. a completion resetting the switch slots
+	DeferTargetingHandleRelease(Handle);
+
+	if (SwitchSlotRequestHandle.Handle == Handle.Handle)
+	{
+		SwitchSlotRequestHandle.Reset();
+	}
+
+	DEC_DWORD_STAT(STAT_TargetSystemActiveTargetingRequests);
+	INC_DWORD_STAT(STAT_TargetSystemCancelledTargetingRequests);
+}
+
+void UNextTargetSystemComponent::CancelTargetingRequests()
+{
+	while (!TargetingHandles.IsEmpty())
+	{
+		CancelTargetingRequest(TargetingHandles.Last());
+	}
+	SwitchSlotRequestHandle.Reset();
+}
+
+void UNextTargetSystemComponent::DeferTargetingHandleRelease(const FTargetingRequestHandle& Handle)
+{
+	DeferredHandleReleases.Add({Handle, GFrameCounter});
+}
+
+void UNextTargetSystemComponent::ReleaseDeferredTargetingHandles(const bool bIncludeThisFrame)
 {
-	for (FTargetingRequestHandle& TargetingHandle : TargetingHandles)
+	for (int32 i = 0; i < DeferredHandleReleases.Num(); ++i)
 	{
-		TargetingHandle.Reset();	
+		if (!bIncludeThisFrame && DeferredHandleReleases[i].Frame == GFrameCounter) continue;
+
+		UTargetingSubsystem::ReleaseTargetRequestHandle(DeferredHandleReleases[i].Handle);
+		DeferredHandleReleases.RemoveAtSwap(i--);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,113 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TSLT_TargetSystemRegistry.h"
+
+#include "GenericTeamAgentInterface.h"
+#include "TargetSystemDependencies.h"
+#include "TargetSystemStats.h"
+#include "TargetSystemSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Types/TargetingSystemTypes.h"
+
+void UTSLT_TargetSystemRegistry::Execute(const FTargetingRequestHandle& TargetingHandle) const
+{
+	Super::Execute(TargetingHandle);
+	SetTaskAsyncState(TargetingHandle, ETargetingTaskAsyncState::Executing);
+
+	TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_RegistrySelectionTask);
+
+	const FTargetingSourceContext* SourceContext = FTargetingSourceContext::Find(TargetingHandle);
+	// The task is an instanced subobject of the preset asset and has no world, the request's source actor has one
+	const UWorld* World = SourceContext && SourceContext->SourceActor ? SourceContext->SourceActor->GetWorld() : nullptr;
+	const UTargetSystemSubsystem* Registry = UTargetSystemSubsystem::Get(World);
+	if (!SourceContext || !Registry)
+	{
+		SetTaskAsyncState(TargetingHandle, ETargetingTaskAsyncState::Completed);
+		return;
+	}
+
+	const FVector SourceLocation = GetSourceLocation(*SourceContext);
+	const FVector SourceDirection = GetSourceDirection(*SourceContext);
+	const float MinConeCos = FMath::Cos(FMath::DegreesToRadians(ConeHalfAngle));
+	const FGenericTeamId SourceTeam = GetTeamId(SourceContext->SourceActor);
+
+	TArray<UTargetSystemDependencies*> Targetables;
+	Registry->QueryTargetablesInRadius(SourceLocation, Radius, Targetables);
+
+	FTargetingDefaultResultsSet& ResultsSet = FTargetingDefaultResultsSet::FindOrAdd(TargetingHandle);
+	for (const UTargetSystemDependencies* Dependencies : Targetables)
+	{
+		AActor* Target = Dependencies->GetOwner();
+		if (!IsValid(Target)) continue;
+		if (bIgnoreSourceActor && Target == SourceContext->SourceActor) continue;
+		if (!Dependencies->GetTargetActorDetails().bCouldBeTarget) continue;
+
+		const FVector TargetLocation = Target->GetActorLocation();
+		const FVector ToTarget = TargetLocation - SourceLocation;
+		if (bUseCone && !ToTarget.IsNearlyZero() && FVector::DotProduct(ToTarget.GetUnsafeNormal(), SourceDirection) < MinConeCos) continue;
+		if (bFilterByTeam && !IsTeamSelected(SourceTeam, Target)) continue;
+
+		const bool bAlreadySelected = ResultsSet.TargetResults.ContainsByPredicate([Target](const FTargetingDefaultResultData& Result)
+		{
+			return Result.HitResult.GetActor() == Target;
+		});
+		if (bAlreadySelected) continue;
+
+		// Filled like the stock AOE selection so the filter and sort tasks read the same fields
+		FTargetingDefaultResultData& Result = ResultsSet.TargetResults.AddDefaulted_GetRef();
+		Result.HitResult.HitObjectHandle = FActorInstanceHandle(Target);
+		Result.HitResult.Location = TargetLocation;
+		Result.HitResult.ImpactPoint = TargetLocation;
+		Result.HitResult.bBlockingHit = true;
+		Result.HitResult.TraceStart = SourceLocation;
+		Result.HitResult.TraceEnd = TargetLocation;
+		Result.HitResult.Distance = ToTarget.Size();
+	}
+
+	SetTaskAsyncState(TargetingHandle, ETargetingTaskAsyncState::Completed);
+}
+
+FVector UTSLT_TargetSystemRegistry::GetSourceLocation(const FTargetingSourceContext& SourceContext)
+{
+	return SourceContext.SourceActor ? SourceContext.SourceActor->GetActorLocation() : SourceContext.SourceLocation;
+}
+
+FVector UTSLT_TargetSystemRegistry::GetSourceDirection(const FTargetingSourceContext& SourceContext)
+{
+	if (const APawn* Pawn = Cast<APawn>(SourceContext.SourceActor))
+	{
+		return Pawn->GetBaseAimRotation().Vector();
+	}
+	return SourceContext.SourceActor ? SourceContext.SourceActor->GetActorForwardVector() : FVector::ForwardVector;
+}
+
+FGenericTeamId UTSLT_TargetSystemRegistry::GetTeamId(const AActor* Actor)
+{
+	if (const IGenericTeamAgentInterface* TeamAgent = Cast<const IGenericTeamAgentInterface>(Actor))
+	{
+		return TeamAgent->GetGenericTeamId();
+	}
+
+	// Pawns usually get their team from their controller
+	const APawn* Pawn = Cast<APawn>(Actor);
+	if (const IGenericTeamAgentInterface* TeamAgent = Pawn ? Cast<const IGenericTeamAgentInterface>(Pawn->GetController()) : nullptr)
+	{
+		return TeamAgent->GetGenericTeamId();
+	}
+	return FGenericTeamId::NoTeam;
+}
+
+bool UTSLT_TargetSystemRegistry::IsTeamSelected(const FGenericTeamId& SourceTeam, const AActor* Target) const
+{
+	switch (FGenericTeamId::GetAttitude(SourceTeam, GetTeamId(Target)))
+	{
+	case ETeamAttitude::Hostile:
+		return bIncludeHostile;
+	case ETeamAttitude::Friendly:
+		return bIncludeFriendly;
+	default:
+		return bIncludeNeutral;
+	}
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TST_FilteredTargetLock.h"
+
+#include "TargetSystemStats.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Types/TargetingSystemTypes.h"
+
+void UTST_FilteredTargetLock::Execute(const FTargetingRequestHandle& TargetingHandle) const
+{
+	FilterTargets(TargetingHandle);
+
+	// Scoring, normalization and ordering stay with USimpleTargetingSortTask so the sort settings of the asset apply
+	Super::Execute(TargetingHandle);
+}
+
+void UTST_FilteredTargetLock::FilterTargets(const FTargetingRequestHandle& TargetingHandle) const
+{
+	TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_FilterAndSortTask);
+
+	const FTargetingSourceContext* SourceContext = FTargetingSourceContext::Find(TargetingHandle);
+	FTargetingDefaultResultsSet* ResultsSet = FTargetingDefaultResultsSet::Find(TargetingHandle);
+	if (!ResultsSet) return;
+
+	TArray<FTargetingDefaultResultData>& TargetResults = ResultsSet->TargetResults;
+	const APawn* PlayerPawn = SourceContext ? Cast<APawn>(SourceContext->SourceActor) : nullptr;
+	const APlayerController* PC = PlayerPawn ? Cast<APlayerController>(PlayerPawn->GetController()) : nullptr;
+	const UTargetLockContext* TargetLockContext = SourceContext ? Cast<UTargetLockContext>(SourceContext->SourceObject) : nullptr;
+	if (!PC || !TargetLockContext)
+	{
+		// UTFT_SwitchTargetLock filters every target out without a controller or a context
+		TargetResults.Reset();
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_TargetSystemCandidatesConsidered, TargetResults.Num());
+
+	// Resolved once for the request, the scores only look up the target data
+	TargetLockContext->SetRequester(PlayerPawn, PC);
+	TargetLockContext->PrecomputeTargetData(TargetResults, PlayerPawn, PC);
+
+	const FTargetSystemViewSnapshot& View = TargetLockContext->GetViewSnapshot();
+	const ETargetSwitchMode Mode = TargetLockContext->Mode;
+	const bool bSwitch = Mode != ETargetSwitchMode::LockOn;
+	const float ViewportCenterX = static_cast<float>(View.GetViewportCenter().X);
+
+	TargetResults.RemoveAll([&](const FTargetingDefaultResultData& TargetResult)
+	{
+		const AActor* TargetActor = TargetResult.HitResult.GetActor();
+		if (!TargetActor || TargetActor == TargetLockContext->CurrentTarget) return true;
+		if (!bSwitch) return false;
+
+		const FTargetLockTargetData& Data = TargetLockContext->GetTargetData(TargetActor);
+		return TargetSystemCore::IsOppositeToSwitch(Data.ScreenPosition.X, ViewportCenterX, Mode == ETargetSwitchMode::SwitchLeft);
+	});
+}
+
+float UTST_FilteredTargetLock::GetScoreForTarget(
+	const FTargetingRequestHandle& TargetingHandle,
+	const FTargetingDefaultResultData& TargetData) const
+{
+	const FTargetingSourceContext* SourceContext = FTargetingSourceContext::Find(TargetingHandle);
+	const UTargetLockContext* TargetLockContext = SourceContext ? Cast<UTargetLockContext>(SourceContext->SourceObject) : nullptr;
+	const AActor* TargetActor = TargetData.HitResult.GetActor();
+	if (!TargetLockContext || !TargetLockContext->HasRequester() || !TargetActor)
+	{
+		return Super::GetScoreForTarget(TargetingHandle, TargetData);
+	}
+
+	// The filter resolved the requester and projected every remaining target, scoring only reads them back
+	const FTargetSystemViewSnapshot& View = TargetLockContext->GetViewSnapshot();
+	const FTargetLockTargetData& Data = TargetLockContext->GetTargetData(TargetActor);
+	return TargetLockContext->Mode == ETargetSwitchMode::LockOn
+		? ComputeLockOnScore(Data, View)
+		: ComputeSwitchScore(Data, View, TargetLockContext->Mode);
+}
@@ -3,13 +3,107 @@
 
 #include "TST_TargetLock.h"
 
-#include "Blueprint/WidgetLayoutLibrary.h"
+#include "TargetSystemLog.h"
+#include "TargetSystemManager.h"
+#include "TargetSystemStats.h"
+#include "Async/ParallelFor.h"
 #include "Types/TargetingSystemTypes.h"
 
+static TAutoConsoleVariable<bool> CVarVerifyBatchScores(
+	TEXT("TargetSystem.VerifyBatchScores"),
+	false,
+	TEXT("Recompute every batched UTST_TargetLock score with the scalar path and log mismatches."));
+
+const FTargetSystemViewSnapshot& UTargetLockContext::GetViewSnapshot(const APawn* Pawn, const APlayerController* PC) const
+{
+	if (!ViewSnapshot.IsCaptured())
+	{
+		ViewSnapshot = FTargetSystemViewSnapshot::Capture(Pawn, PC);
+	}
+	return ViewSnapshot;
+}
+
+const FTargetLockTargetData& UTargetLockContext::GetTargetData(const AActor* Target, const APawn* Pawn, const APlayerController* PC) const
+{
+	if (const FTargetLockTargetData* Data = TargetData.Find(Target))
+	{
+		return *Data;
+	}
+	return TargetData.Add(Target, FTargetLockTargetData::Make(Target, Pawn, GetViewSnapshot(Pawn, PC)));
+}
+
+void UTargetLockContext::PrecomputeTargetData(
+	const TArray<FTargetingDefaultResultData>& TargetResults, const APawn* Pawn, const APlayerController* PC) const
+{
+	if (!UTargetSystemManager::ShouldEvaluateInParallel(TargetResults.Num())) return;
+
+	const FTargetSystemViewSnapshot& View = GetViewSnapshot(Pawn, PC);
+
+	// Locations are read on the game thread, only the projections run on the workers
+	TArray<const AActor*, TInlineAllocator<128>> Targets;
+	TArray<FVector, TInlineAllocator<128>> Locations;
+	for (const FTargetingDefaultResultData& TargetResult : TargetResults)
+	{
+		const AActor* Target = TargetResult.HitResult.GetActor();
+		if (!Target || TargetData.Contains(Target)) continue;
+
+		Targets.Add(Target);
+		Locations.Add(Target->GetActorLocation());
+	}
+
+	TArray<FTargetLockTargetData, TInlineAllocator<128>> Data;
+	Data.SetNum(Targets.Num());
+
+	const FVector PawnLocation = Pawn->GetActorLocation();
+	ParallelFor(Targets.Num(), [&Data, &Locations, &View, PawnLocation](const int32 i)
+	{
+		Data[i] = FTargetLockTargetData::Make(Locations[i], PawnLocation, View);
+	});
+
+	for (int32 i = 0; i < Targets.Num(); ++i)
+	{
+		TargetData.Add(Targets[i], Data[i]);
+	}
+}
+
+FTargetLockTargetData FTargetLockTargetData::Make(const AActor* Target, const APawn* Pawn, const FTargetSystemViewSnapshot& View)
+{
+	return Make(Target->GetActorLocation(), Pawn->GetActorLocation(), View);
+}
+
+FTargetLockTargetData FTargetLockTargetData::Make(const FVector& TargetLocation, const FVector& PawnLocation, const FTargetSystemViewSnapshot& View)
+{
+	FTargetLockTargetData Data;
+	View.ProjectWorldToScreen(TargetLocation, Data.ScreenPosition);
+	Data.Distance = FVector::Distance(PawnLocation, TargetLocation);
+	return Data;
+}
+
+void UTargetLockContext::Reset()
+{
+	Mode = ETargetSwitchMode::LockOn;
+	CurrentTarget = nullptr;
+	RequesterPawn = nullptr;
+	RequesterController = nullptr;
+	ViewSnapshot = FTargetSystemViewSnapshot();
+	TargetData.Reset();
+
+	// The results pointer of a later request may match, so the batch must not look built for it
+	ScoreBatch.Scorer = nullptr;
+	ScoreBatch.Results = nullptr;
+	ScoreBatch.NumResults = 0;
+	ScoreBatch.Scores.Reset();
+	ScoreBatch.X.Reset();
+	ScoreBatch.Y.Reset();
+	ScoreBatch.Z.Reset();
+}
+
 float UTST_TargetLock::GetScoreForTarget(
 	const FTargetingRequestHandle& TargetingHandle,
 	const FTargetingDefaultResultData& TargetData) const
 {
+	TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_SortTaskScore);
+
 	const FTargetingSourceContext* SourceContext = FTargetingSourceContext::Find(TargetingHandle);
 	if (!SourceContext)
 		return FLT_MAX;
@@ -27,59 +121,220 @@ float UTST_TargetLock::GetScoreForTarget(
 	if (!TargetActor)
 		return FLT_MAX;
 
-	if (!TargetLockContext || TargetLockContext->Mode == ETargetSwitchMode::LockOn)
+	if (!TargetLockContext)
 	{
-		return ComputeLockOnScore(TargetActor, PlayerPawn, PC);
+		const FTargetSystemViewSnapshot View = FTargetSystemViewSnapshot::Capture(PlayerPawn, PC);
+		return ComputeLockOnScore(FTargetLockTargetData::Make(TargetActor, PlayerPawn, View), View);
 	}
-	else
+
+	const FTargetSystemViewSnapshot& View = TargetLockContext->GetViewSnapshot(PlayerPawn, PC);
+	if (bUseBatchScoring)
+	{
+		if (const FTargetingDefaultResultsSet* ResultsSet = FTargetingDefaultResultsSet::Find(TargetingHandle))
+		{
+			const TArray<FTargetingDefaultResultData>& TargetResults = ResultsSet->TargetResults;
+			const int32 Index = static_cast<int32>(&TargetData - TargetResults.GetData());
+			if (TargetResults.IsValidIndex(Index) && &TargetResults[Index] == &TargetData)
+			{
+				FTargetLockScoreBatch& Batch = TargetLockContext->GetScoreBatch();
+				if (!Batch.IsBuiltFor(this, TargetResults.GetData(), TargetResults.Num()))
+				{
+					BuildScoreBatch(Batch, TargetResults, PlayerPawn, View, TargetLockContext);
+				}
+
+				if (CVarVerifyBatchScores.GetValueOnGameThread())
+				{
+					const FTargetLockTargetData Data = FTargetLockTargetData::Make(TargetActor, PlayerPawn, View);
+					const float ScalarScore = TargetLockContext->Mode == ETargetSwitchMode::LockOn ? ComputeLockOnScore(Data, View) :
+						TargetLockContext->CurrentTarget == TargetActor ? FLT_MAX : ComputeSwitchScore(Data, View, TargetLockContext->Mode);
+					if (!FMath::IsNearlyEqual(ScalarScore, Batch.Scores[Index], FMath::Max(1.e-3f, FMath::Abs(ScalarScore) * 1.e-4f)))
+					{
+						TS_LOG(Warning, TEXT("UTST_TargetLock: batch score %f differs from scalar score %f for %s"),
+							Batch.Scores[Index], ScalarScore, *TargetActor->GetName());
+					}
+				}
+
+				return Batch.Scores[Index];
+			}
+		}
+	}
+
+	const FTargetLockTargetData& Data = TargetLockContext->GetTargetData(TargetActor, PlayerPawn, PC);
+	if (TargetLockContext->Mode == ETargetSwitchMode::LockOn)
 	{
-		return ComputeSwitchScore(TargetActor, PlayerPawn, PC, TargetLockContext);
+		return ComputeLockOnScore(Data, View);
 	}
+	if (TargetLockContext->CurrentTarget == TargetActor)
+	{
+		return FLT_MAX;
+	}
+	return ComputeSwitchScore(Data, View, TargetLockContext->Mode);
 }
 
-float UTST_TargetLock::ComputeLockOnScore(
-	const AActor* TargetActor, const APawn* PlayerPawn, APlayerController* PC) const
+void UTST_TargetLock::BuildScoreBatch(
+	FTargetLockScoreBatch& Batch,
+	const TArray<FTargetingDefaultResultData>& TargetResults,
+	const APawn* PlayerPawn, const FTargetSystemViewSnapshot& View,
+	const UTargetLockContext* TargetLockContext) const
 {
-	const float Distance = FVector::Distance(PlayerPawn->GetActorLocation(), TargetActor->GetActorLocation());
-	const float DistScore = DistanceScale > 0.f ? Distance / DistanceScale : Distance;
+	TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_SortTaskBuildBatch);
+	INC_DWORD_STAT_BY(STAT_TargetSystemCandidatesConsidered, TargetResults.Num());
+
+	const int32 NumTargets = TargetResults.Num();
+	const int32 NumPadded = Align(NumTargets, 4);
+
+	Batch.Scorer = this;
+	Batch.Results = TargetResults.GetData();
+	Batch.NumResults = NumTargets;
+	Batch.X.SetNumZeroed(NumPadded);
+	Batch.Y.SetNumZeroed(NumPadded);
+	Batch.Z.SetNumZeroed(NumPadded);
+	Batch.Scores.SetNumUninitialized(NumPadded);
+
+	// Work relative to the view origin so large world coordinates fit in floats
+	const FVector Origin = View.ViewLocation;
+	for (int32 i = 0; i < NumTargets; ++i)
+	{
+		const AActor* TargetActor = TargetResults[i].HitResult.GetActor();
+		if (!TargetActor) continue;
+
+		const FVector Relative = TargetActor->GetActorLocation() - Origin;
+		Batch.X[i] = static_cast<float>(Relative.X);
+		Batch.Y[i] = static_cast<float>(Relative.Y);
+		Batch.Z[i] = static_cast<float>(Relative.Z);
+	}
+
+	const bool bSwitch = TargetLockContext->Mode != ETargetSwitchMode::LockOn;
+	FVector2D Center = View.GetViewportCenter();
+	if (bSwitch)
+	{
+		Center.X = TargetSystemCore::GetSwitchCenterX(Center.X, TargetLockContext->Mode == ETargetSwitchMode::SwitchLeft, ScreenOffsetScale);
+	}
+
+	// Without a projection every target projects to the origin, as in the scalar path
+	const FMatrix44f Projection = View.HasProjection() ?
+		FMatrix44f(FTranslationMatrix(Origin) * View.ViewProjectionMatrix) :
+		FMatrix44f(ForceInitToZero);
+	const FVector3f PawnRelative = FVector3f(PlayerPawn->GetActorLocation() - Origin);
+
+	const float ScreenFactor = (ScreenOffsetScale > 0.f ? 1.f / ScreenOffsetScale : 1.f) * ScreenWeight;
+	const float DistanceFactor = (DistanceScale > 0.f ? 1.f / DistanceScale : 1.f) * DistanceWeight;
+
+	const VectorRegister4Float Zero = VectorZeroFloat();
+	const VectorRegister4Float One = VectorOneFloat();
+	const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+
+	const VectorRegister4Float M00 = VectorSetFloat1(Projection.M[0][0]);
+	const VectorRegister4Float M10 = VectorSetFloat1(Projection.M[1][0]);
+	const VectorRegister4Float M20 = VectorSetFloat1(Projection.M[2][0]);
+	const VectorRegister4Float M30 = VectorSetFloat1(Projection.M[3][0]);
+	const VectorRegister4Float M01 = VectorSetFloat1(Projection.M[0][1]);
+	const VectorRegister4Float M11 = VectorSetFloat1(Projection.M[1][1]);
+	const VectorRegister4Float M21 = VectorSetFloat1(Projection.M[2][1]);
+	const VectorRegister4Float M31 = VectorSetFloat1(Projection.M[3][1]);
+	const VectorRegister4Float M03 = VectorSetFloat1(Projection.M[0][3]);
+	const VectorRegister4Float M13 = VectorSetFloat1(Projection.M[1][3]);
+	const VectorRegister4Float M23 = VectorSetFloat1(Projection.M[2][3]);
+	const VectorRegister4Float M33 = VectorSetFloat1(Projection.M[3][3]);
+
+	const VectorRegister4Float RectMinX = VectorSetFloat1(static_cast<float>(View.ViewRect.Min.X));
+	const VectorRegister4Float RectMinY = VectorSetFloat1(static_cast<float>(View.ViewRect.Min.Y));
+	const VectorRegister4Float RectWidth = VectorSetFloat1(static_cast<float>(View.ViewRect.Width()));
+	const VectorRegister4Float RectHeight = VectorSetFloat1(static_cast<float>(View.ViewRect.Height()));
+	const VectorRegister4Float CenterX = VectorSetFloat1(static_cast<float>(Center.X));
+	const VectorRegister4Float CenterY = VectorSetFloat1(static_cast<float>(Center.Y));
+	const VectorRegister4Float PawnX = VectorSetFloat1(PawnRelative.X);
+	const VectorRegister4Float PawnY = VectorSetFloat1(PawnRelative.Y);
+	const VectorRegister4Float PawnZ = VectorSetFloat1(PawnRelative.Z);
+	const VectorRegister4Float ScreenScale = VectorSetFloat1(ScreenFactor);
+	const VectorRegister4Float DistanceScaleFactor = VectorSetFloat1(DistanceFactor);
+
+	const auto ScoreFourTargets = [&](const int32 i)
+	{
+		const VectorRegister4Float X = VectorLoad(&Batch.X[i]);
+		const VectorRegister4Float Y = VectorLoad(&Batch.Y[i]);
+		const VectorRegister4Float Z = VectorLoad(&Batch.Z[i]);
+
+		// Same math as FSceneView::ProjectWorldToScreen and the TargetSystemCore scores, four targets at a time
+		const VectorRegister4Float ClipX = VectorMultiplyAdd(X, M00, VectorMultiplyAdd(Y, M10, VectorMultiplyAdd(Z, M20, M30)));
+		const VectorRegister4Float ClipY = VectorMultiplyAdd(X, M01, VectorMultiplyAdd(Y, M11, VectorMultiplyAdd(Z, M21, M31)));
+		const VectorRegister4Float ClipW = VectorMultiplyAdd(X, M03, VectorMultiplyAdd(Y, M13, VectorMultiplyAdd(Z, M23, M33)));
 
-	FVector2D ScreenLoc;
-	PC->ProjectWorldLocationToScreen(TargetActor->GetActorLocation(), ScreenLoc);
+		const VectorRegister4Float InFront = VectorCompareGT(ClipW, Zero);
+		const VectorRegister4Float RHW = VectorDivide(One, VectorSelect(InFront, ClipW, One));
 
-	const FVector2D ViewportSize = UWidgetLayoutLibrary::GetViewportSize(PC);
-	const FVector2D ScreenCenter = ViewportSize * 0.5f;
+		const VectorRegister4Float NormalizedX = VectorMultiplyAdd(VectorMultiply(ClipX, RHW), Half, Half);
+		const VectorRegister4Float NormalizedY = VectorSubtract(Half, VectorMultiply(VectorMultiply(ClipY, RHW), Half));
+		const VectorRegister4Float ScreenX = VectorSelect(InFront, VectorMultiplyAdd(NormalizedX, RectWidth, RectMinX), Zero);
+		const VectorRegister4Float ScreenY = VectorSelect(InFront, VectorMultiplyAdd(NormalizedY, RectHeight, RectMinY), Zero);
 
-	const float PixelOffset = FVector2D::Distance(ScreenLoc, ScreenCenter);
-	const float ScreenScore = ScreenOffsetScale > 0.f ? PixelOffset / ScreenOffsetScale : PixelOffset;
+		const VectorRegister4Float DeltaX = VectorSubtract(ScreenX, CenterX);
+		VectorRegister4Float ScreenOffset;
+		if (bSwitch)
+		{
+			ScreenOffset = VectorAbs(DeltaX);
+		}
+		else
+		{
+			const VectorRegister4Float DeltaY = VectorSubtract(ScreenY, CenterY);
+			ScreenOffset = VectorSqrt(VectorMultiplyAdd(DeltaX, DeltaX, VectorMultiply(DeltaY, DeltaY)));
+		}
 
-	return ScreenScore * ScreenWeight + DistScore * DistanceWeight;
+		const VectorRegister4Float ToTargetX = VectorSubtract(X, PawnX);
+		const VectorRegister4Float ToTargetY = VectorSubtract(Y, PawnY);
+		const VectorRegister4Float ToTargetZ = VectorSubtract(Z, PawnZ);
+		const VectorRegister4Float Distance = VectorSqrt(
+			VectorMultiplyAdd(ToTargetX, ToTargetX, VectorMultiplyAdd(ToTargetY, ToTargetY, VectorMultiply(ToTargetZ, ToTargetZ))));
+
+		VectorStore(VectorMultiplyAdd(ScreenOffset, ScreenScale, VectorMultiply(Distance, DistanceScaleFactor)), &Batch.Scores[i]);
+	};
+
+	// Every group of four is independent, so both paths give the same scores
+	if (UTargetSystemManager::ShouldEvaluateInParallel(NumTargets))
+	{
+		ParallelFor(NumPadded / 4, [&ScoreFourTargets](const int32 Group) { ScoreFourTargets(Group * 4); });
+	}
+	else
+	{
+		for (int32 i = 0; i < NumPadded; i += 4)
+		{
+			ScoreFourTargets(i);
+		}
+	}
+
+	for (int32 i = 0; i < NumTargets; ++i)
+	{
+		const AActor* TargetActor = TargetResults[i].HitResult.GetActor();
+		if (!TargetActor || (bSwitch && TargetLockContext->CurrentTarget == TargetActor))
+		{
+			Batch.Scores[i] = FLT_MAX;
+		}
+	}
 }
 
-float UTST_TargetLock::ComputeSwitchScore(
-	const AActor* TargetActor, const APawn* PlayerPawn, APlayerController* PC,
-	const UTargetLockContext* TargetLockContext) const
+TargetSystemCore::FScoreParams UTST_TargetLock::GetScoreParams() const
 {
-	if (TargetLockContext->CurrentTarget == TargetActor)
-		return FLT_MAX;
-
-	const FVector2D ViewportSize = UWidgetLayoutLibrary::GetViewportSize(PC);
-	FVector2D Center = ViewportSize * 0.5f;
-	const float InputDirection = TargetLockContext->Mode == ETargetSwitchMode::SwitchLeft ? -1.f : +1.f;
-	Center.X += InputDirection * (ScreenOffsetScale * 0.5f);
+	TargetSystemCore::FScoreParams Params;
+	Params.ScreenWeight = ScreenWeight;
+	Params.DistanceWeight = DistanceWeight;
+	Params.DistanceScale = DistanceScale;
+	Params.ScreenOffsetScale = ScreenOffsetScale;
+	return Params;
+}
 
-	FVector2D ScreenPos;
-	PC->ProjectWorldLocationToScreen(TargetActor->GetActorLocation(), ScreenPos);
-	float ScreenDelta = FMath::Abs(ScreenPos.X - Center.X);
-	if (ScreenOffsetScale > 0)
-		ScreenDelta /= ScreenOffsetScale;
+float UTST_TargetLock::ComputeLockOnScore(const FTargetLockTargetData& Data, const FTargetSystemViewSnapshot& View) const
+{
+	const FVector2D ScreenCenter = View.GetViewportCenter();
 
-	float Dist = FVector::Distance(PlayerPawn->GetActorLocation(), TargetActor->GetActorLocation());
-	if (DistanceScale > 0)
-		Dist /= DistanceScale;
+	return TargetSystemCore::ComputeLockOnScore(
+		Data.Distance, Data.ScreenPosition.X, Data.ScreenPosition.Y, ScreenCenter.X, ScreenCenter.Y, GetScoreParams());
+}
 
-	UE_LOG(LogTemp, Warning, TEXT("Target Name: %s, Distance: %f, ScreenDelta: %f, Sum: %f"),
-		*TargetActor->GetName(), Dist, ScreenDelta,
-		ScreenDelta * ScreenWeight + Dist * DistanceWeight);
+float UTST_TargetLock::ComputeSwitchScore(
+	const FTargetLockTargetData& Data, const FTargetSystemViewSnapshot& View, const ETargetSwitchMode Mode) const
+{
+	const float CenterX = TargetSystemCore::GetSwitchCenterX(
+		View.GetViewportCenter().X, Mode == ETargetSwitchMode::SwitchLeft, ScreenOffsetScale);
 
-	return ScreenDelta * ScreenWeight + Dist * DistanceWeight;
-}
\ No newline at end of file
+	return TargetSystemCore::ComputeSwitchScore(Data.Distance, Data.ScreenPosition.X, CenterX, GetScoreParams());
+}
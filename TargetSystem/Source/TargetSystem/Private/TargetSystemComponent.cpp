@@ -4,22 +4,84 @@
 #include "BTargetPoint.h"
 #include "..\Public\TargetSystemInterface.h"
 #include "Components/WidgetComponent.h"
-#include "EngineUtils.h"
 #include "TargetActorDetails.h"
 #include "TargetSystemDependencies.h"
 #include "TargetSystemLog.h"
-#include "Camera/CameraComponent.h"
+#include "TargetSystemManager.h"
+#include "TargetSystemStats.h"
+#include "TargetSystemSubsystem.h"
+#include "Async/ParallelFor.h"
 #include "Engine/World.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/PlayerController.h"
+#include "LatentActions.h"
+
+/** Latent action of TryStartTargetLockLatent, finishes once the component resolved the lock */
+class FTargetLockLatentAction : public FPendingLatentAction
+{
+public:
+    FTargetLockLatentAction(const FLatentActionInfo& LatentInfo, ETargetLockAsyncResult& InResult, AActor*& InTarget)
+        : ExecutionFunction(LatentInfo.ExecutionFunction)
+        , OutputLink(LatentInfo.Linkage)
+        , CallbackTarget(LatentInfo.CallbackTarget)
+        , Result(InResult)
+        , Target(InTarget)
+    {
+    }
+
+    virtual ~FTargetLockLatentAction() override
+    {
+        if (Component.IsValid())
+        {
+            Component->CancelTargetLockAsync(Handle);
+        }
+    }
+
+    void Start(UTargetSystemComponent* InComponent)
+    {
+        Component = InComponent;
+        Handle = InComponent->TryStartTargetLockAsync(FOnTargetLockResult::CreateRaw(this, &FTargetLockLatentAction::OnResolved));
+    }
+
+    virtual void UpdateOperation(FLatentResponse& Response) override
+    {
+        if (!bResolved) return;
+
+        Result = LockedTarget.IsValid() ? ETargetLockAsyncResult::Locked : ETargetLockAsyncResult::Failed;
+        Target = LockedTarget.Get();
+        Response.FinishAndTriggerIf(true, ExecutionFunction, OutputLink, CallbackTarget);
+    }
+
+private:
+    void OnResolved(AActor* InLockedTarget)
+    {
+        bResolved = true;
+        LockedTarget = InLockedTarget;
+        Handle.Reset();
+    }
+
+    FName ExecutionFunction;
+    int32 OutputLink;
+    FWeakObjectPtr CallbackTarget;
+    ETargetLockAsyncResult& Result;
+    AActor*& Target;
+
+    TWeakObjectPtr<UTargetSystemComponent> Component;
+    FDelegateHandle Handle;
+    TWeakObjectPtr<AActor> LockedTarget;
+    bool bResolved = false;
+};
 
 UTargetSystemComponent::UTargetSystemComponent()
 {
-    PrimaryComponentTick.bCanEverTick = true;
+    // Ticked in batch by UTargetSystemManager while locked
+    PrimaryComponentTick.bCanEverTick = false;
 
     LockedOnWidgetClass = StaticLoadClass(UObject::StaticClass(), nullptr, TEXT("/TargetSystem/UI/WBP_LockOn.WBP_LockOn_C"));
     RequiredClass = APawn::StaticClass();
     TargetCollisionChannel = ECC_Pawn;
+
+    UpdatePolicies();
 }
 
 void UTargetSystemComponent::SetUp(
@@ -29,11 +91,42 @@ void UTargetSystemComponent::SetUp(
 {
     bAdjustPitchBasedOnDistanceToTarget = _bAdjustPitchBasedOnDistanceToTarget;
     bAdjustPitchBasedOnDistanceToTargetUsingCurve = _bAdjustPitchBasedOnDistanceToTargetUsingCurve;
+    UpdatePolicies();
+}
+
+void UTargetSystemComponent::SetIgnoreViewport(const bool bValue)
+{
+    bIgnoreViewport = bValue;
+    UpdatePolicies();
+}
+
+void UTargetSystemComponent::SetAdjustPitchBasedOnDistanceToTarget(const bool bValue)
+{
+    bAdjustPitchBasedOnDistanceToTarget = bValue;
+    UpdatePolicies();
 }
 
+void UTargetSystemComponent::SetAdjustPitchBasedOnDistanceToTargetUsingCurve(const bool bValue)
+{
+    bAdjustPitchBasedOnDistanceToTargetUsingCurve = bValue;
+    UpdatePolicies();
+}
+
+#if WITH_EDITOR
+void UTargetSystemComponent::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+
+    // Details panel edits, PIE included, bypass the setters
+    UpdatePolicies();
+}
+#endif
+
 void UTargetSystemComponent::BeginPlay()
 {
 	Super::BeginPlay();
+	UpdatePolicies();
+
 	OwnerActor = GetOwner();
 	if (!OwnerActor)
 	{
@@ -54,15 +147,79 @@ void UTargetSystemComponent::BeginPlay()
     }
 
 	SetupLocalPlayerController();
+
+    if (OwnerPawn->IsLocallyControlled())
+    {
+        GetOrCreateTargetLockedOnWidgetComponent();
+    }
 }
 
-void UTargetSystemComponent::TickComponent(const float DeltaTime, const ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+void UTargetSystemComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+    if (TargetLockedOnWidgetComponent)
+    {
+        TargetLockedOnWidgetComponent->DestroyComponent();
+        TargetLockedOnWidgetComponent = nullptr;
+    }
 
-    if (!bTargetLocked || !NearestTarget) return;
+    UnbindTargetInvalidation();
+    CancelPendingTargetQuery();
+    if (UTargetSystemManager* TargetSystemManager = UTargetSystemManager::Get(GetWorld()))
+    {
+        TargetSystemManager->UnregisterActiveComponent(this);
+    }
+    ResolvePendingLockResults(nullptr);
 
-    SetControlRotationOnTarget();
+    Super::EndPlay(EndPlayReason);
+}
+
+bool UTargetSystemComponent::TickTargetSystem(const float DeltaTime)
+{
+    TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_TickComponent);
+
+    const double Now = GetWorld()->GetTimeSeconds();
+    if (SwitchCooldownEndTime > 0.0 && Now >= SwitchCooldownEndTime)
+    {
+        SwitchCooldownEndTime = 0.0;
+        bIsSwitchingTarget = false;
+    }
+
+    // The lock is left alone while its replacement waits for the query budget
+    if (IsLocked() && !PendingTargetQuery)
+    {
+        if (BreakLineOfSightTime > 0.0 && Now >= BreakLineOfSightTime)
+        {
+            BreakLineOfSightTime = 0.0;
+            StopObservingTarget(true);
+        }
+        else if (NextLockCheckTime > 0.0 && Now >= NextLockCheckTime)
+        {
+            NextLockCheckTime = 0.0;
+            UpdateTargetInfo();
+        }
+    }
+
+    if (IsLocked() && !PendingTargetQuery)
+    {
+        SetControlRotationOnTarget();
+
+        if (bPrecomputeSwitchTargets)
+        {
+            UpdateSwitchSlots();
+        }
+    }
+
+    return IsLocked() || SwitchCooldownEndTime > 0.0;
+}
+
+void UTargetSystemComponent::RequestManagerTick()
+{
+    if (bTickedByManager) return;
+
+    if (UTargetSystemManager* TargetSystemManager = UTargetSystemManager::Get(GetWorld()))
+    {
+        TargetSystemManager->RegisterActiveComponent(this);
+    }
 }
 
 bool UTargetSystemComponent::CanTargetLock() const
@@ -74,7 +231,10 @@ void UTargetSystemComponent::StartObservingTarget()
 {
     bTargetLocked = true;
     NearestTarget->StartTargetable();
-    CurrentSocketOnNearestTarget = GetTargetDetails(NearestTarget).StartTargetPointName;
+
+    const FTargetActorDetails& TargetDetails = GetTargetDetails(NearestTarget);
+    CurrentTargetPointIndex = TargetDetails.TargetPoints.IsValidIndex(TargetDetails.StartTargetPointIndex) ? TargetDetails.StartTargetPointIndex : INDEX_NONE;
+    CurrentSocketOnNearestTarget = TargetDetails.StartTargetPointName;
 
     if (OnTargetLockedOn.IsBound())
     {
@@ -89,31 +249,144 @@ void UTargetSystemComponent::StartObservingTarget()
         OwnerPlayerController->SetIgnoreLookInput(true);
     }
 
-    CreateAndAttachTargetLockedOnWidgetComponent(NearestTarget);
+    AttachTargetLockedOnWidgetComponent(NearestTarget);
+    BindTargetInvalidation();
+    ResetSwitchSlots();
 
-    GetWorld()->GetTimerManager().SetTimer(ObservingTimer, this, &UTargetSystemComponent::UpdateTargetInfo, TimerTick, true);
+    bLockCheckPending = true;
+    bLastLineOfSight = true;
+    LastVisibilityChangeTime = -1.f;
+    LastLockCheckTime = GetWorld()->GetTimeSeconds();
+    ScheduleLockCheck();
+
+    ResolvePendingLockResults(NearestTarget->GetTargetSystemDependencies()->GetOwner());
 }
 
 void UTargetSystemComponent::UpdateTargetInfo()
 {
-    FHitResult Hit;
-    if(NearestTarget->IsTargetable() && !LineTrace(GetOwner()->GetActorLocation(), GetTargetOwnerLocation(NearestTarget), Hit))
+    TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_UpdateTargetInfo);
+
+    const float Now = GetWorld()->GetTimeSeconds();
+    INC_DWORD_STAT(STAT_TargetSystemLockChecks);
+    INC_FLOAT_STAT_BY(STAT_TargetSystemLockChecksAvoided, TimerTick > 0.f ? (Now - LastLockCheckTime) / TimerTick - 1.f : 0.f);
+    LastLockCheckTime = Now;
+
+    if (CheckLockedTarget())
     {
-        if (BehindWallTimer.IsValid()) return;
-        GetWorld()->GetTimerManager().SetTimer(BehindWallTimer, [this]() { StopObservingTarget(true); }, BreakLineOfSightDelay, false);
-        return;
+        ScheduleLockCheck();
     }
-    GetWorld()->GetTimerManager().ClearTimer(BehindWallTimer);
+}
+
+bool UTargetSystemComponent::CheckLockedTarget()
+{
+    if (!NearestTarget) return false;
 
-    if (NearestTarget
-        && NearestTarget->IsTargetable()
-        && GetDistanceFromTarget(NearestTarget) <= LoseTargetDistance) return;
+    const bool bTargetable = NearestTarget->IsTargetable();
+    if (bTargetable && !ShouldRecheckLock()) return true;
+
+    const bool bLineOfSight = !bTargetable || HasLineOfSight(NearestTarget);
+    if (bLineOfSight != bLastLineOfSight)
+    {
+        bLastLineOfSight = bLineOfSight;
+        LastVisibilityChangeTime = GetWorld()->GetTimeSeconds();
+    }
+
+    if (!bLineOfSight)
+    {
+        if (BreakLineOfSightTime <= 0.0)
+        {
+            BreakLineOfSightTime = GetWorld()->GetTimeSeconds() + BreakLineOfSightDelay;
+        }
+        return true;
+    }
+    BreakLineOfSightTime = 0.0;
+
+    if (bTargetable && GetDistanceFromTarget(NearestTarget) <= LoseTargetDistance) return true;
+
+    StopObservingTarget(false, true);
+    return false;
+}
+
+void UTargetSystemComponent::ScheduleLockCheck()
+{
+    NextLockCheckTime = GetWorld()->GetTimeSeconds() + GetLockCheckInterval();
+    RequestManagerTick();
+}
+
+float UTargetSystemComponent::GetLockCheckInterval() const
+{
+    if (!bUseAdaptiveLockCheckInterval || !NearestTarget) return TimerTick;
+
+    const AActor* TargetActor = NearestTarget->GetTargetSystemDependencies()->GetOwner();
+    const FVector ToTarget = TargetActor->GetActorLocation() - OwnerActor->GetActorLocation();
+    const float Distance = ToTarget.Size();
+
+    const FVector RelativeVelocity = TargetActor->GetVelocity() - OwnerActor->GetVelocity();
+    const float SeparationSpeed = Distance > UE_KINDA_SMALL_NUMBER ? FVector::DotProduct(RelativeVelocity, ToTarget / Distance) : 0.f;
+
+    const float Now = GetWorld()->GetTimeSeconds();
+    const bool bVisibilityUnstable = BreakLineOfSightTime > 0.0
+        || (LastVisibilityChangeTime >= 0.f && Now - LastVisibilityChangeTime < MaxLockCheckInterval);
+
+    TargetSystemCore::FLockCheckIntervalParams Params;
+    Params.MinInterval = MinLockCheckInterval;
+    Params.MaxInterval = FMath::Max(MinLockCheckInterval, MaxLockCheckInterval);
+
+    return TargetSystemCore::GetLockCheckInterval(LoseTargetDistance - Distance, SeparationSpeed, bVisibilityUnstable, Params);
+}
+
+bool UTargetSystemComponent::ShouldRecheckLock()
+{
+    const FVector OwnerLocation = OwnerActor->GetActorLocation();
+    const FVector TargetLocation = GetTargetOwnerLocation(NearestTarget);
+
+    // Keep checking while the target is behind a wall so the break timer is cleared as soon as it is visible again
+    const bool bBehindWall = BreakLineOfSightTime > 0.0;
+    if (!bLockCheckPending && !bBehindWall && LockRecheckDistance > 0.f
+        && FVector::DistSquared(OwnerLocation, LastCheckedOwnerLocation) < FMath::Square(LockRecheckDistance)
+        && FVector::DistSquared(TargetLocation, LastCheckedTargetLocation) < FMath::Square(LockRecheckDistance))
+    {
+        return false;
+    }
+
+    bLockCheckPending = false;
+    LastCheckedOwnerLocation = OwnerLocation;
+    LastCheckedTargetLocation = TargetLocation;
+    return true;
+}
+
+void UTargetSystemComponent::BindTargetInvalidation()
+{
+    UnbindTargetInvalidation();
+
+    UTargetSystemDependencies* Dependencies = NearestTarget->GetTargetSystemDependencies();
+    if (!IsValid(Dependencies)) return;
+
+    ObservedDependencies = Dependencies;
+    TargetInvalidatedHandle = Dependencies->OnTargetInvalidated.AddUObject(this, &UTargetSystemComponent::OnTargetInvalidated);
+}
+
+void UTargetSystemComponent::UnbindTargetInvalidation()
+{
+    if (UTargetSystemDependencies* Dependencies = ObservedDependencies.Get())
+    {
+        Dependencies->OnTargetInvalidated.Remove(TargetInvalidatedHandle);
+    }
+    ObservedDependencies.Reset();
+    TargetInvalidatedHandle.Reset();
+}
+
+void UTargetSystemComponent::OnTargetInvalidated(UTargetSystemDependencies* Dependencies, const ETargetInvalidationReason Reason)
+{
+    if (!NearestTarget || NearestTarget->GetTargetSystemDependencies() != Dependencies) return;
 
     StopObservingTarget(false, true);
 }
 
 void UTargetSystemComponent::StopObservingTarget(const bool bIgnoreAutoSwitch, const bool bTargetIsDead)
 {
+    UnbindTargetInvalidation();
+
     if (NearestTarget)
     {
         if (OnTargetLockedOff.IsBound())
@@ -124,6 +397,7 @@ void UTargetSystemComponent::StopObservingTarget(const bool bIgnoreAutoSwitch, c
         NearestTarget->StopTargetable();
         if (bTargetIsDead)
         {
+            VisibilityCache.Remove(NearestTarget.GetObject());
             PotentialTargets.Remove(NearestTarget);
             if (OnTargetIsDead.IsBound())
             {
@@ -131,12 +405,10 @@ void UTargetSystemComponent::StopObservingTarget(const bool bIgnoreAutoSwitch, c
             }
         }
     }
-    GetWorld()->GetTimerManager().ClearTimer(ObservingTimer);
+    NextLockCheckTime = 0.0;
+    BreakLineOfSightTime = 0.0;
 
-    if (TargetLockedOnWidgetComponent)
-    {
-        TargetLockedOnWidgetComponent->DestroyComponent();
-    }
+    HideTargetLockedOnWidgetComponent();
 
     if (bIsSwitchingTarget) return;
 
@@ -149,16 +421,23 @@ void UTargetSystemComponent::StopObservingTarget(const bool bIgnoreAutoSwitch, c
     StopTargetLock();
 }
 
-void UTargetSystemComponent::MessageFinishTargetLock() const
+void UTargetSystemComponent::MessageFinishTargetLock()
 {
     if (OnFinishTargetLock.IsBound())
     {
         OnFinishTargetLock.Broadcast();
     }
+
+    ResolvePendingLockResults(nullptr);
 }
 
 void UTargetSystemComponent::TryStartTargetLock()
 {
+    TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_TryStartTargetLock);
+    TARGETSYSTEM_TRACE_OBJECT_SCOPE(OwnerActor);
+
+    if (PendingTargetQuery) return;
+
     AddPotentialTargetsByInterface(RequiredClass);
     if (!CanTargetLock())
     {
@@ -166,6 +445,58 @@ void UTargetSystemComponent::TryStartTargetLock()
         return;
     }
 
+    if (VisibilityTraceMode == ETargetVisibilityTraceMode::Asynchronous)
+    {
+        StartVisibilityQuery(EVisibilityQueryType::Lock);
+        return;
+    }
+
+    RequestTargetQuery(&UTargetSystemComponent::FinishTryStartTargetLock, true);
+}
+
+FDelegateHandle UTargetSystemComponent::TryStartTargetLockAsync(FOnTargetLockResult OnResult)
+{
+    // Registered first as the lock may resolve before TryStartTargetLock returns
+    const FDelegateHandle Handle(FDelegateHandle::GenerateNewHandle);
+    PendingLockResults.Add({Handle, MoveTemp(OnResult)});
+
+    TryStartTargetLock();
+    return Handle;
+}
+
+void UTargetSystemComponent::CancelTargetLockAsync(const FDelegateHandle Handle)
+{
+    PendingLockResults.RemoveAll([&Handle](const FPendingLockResult& Pending) { return Pending.Handle == Handle; });
+}
+
+void UTargetSystemComponent::TryStartTargetLockLatent(ETargetLockAsyncResult& Result, AActor*& Target, const FLatentActionInfo LatentInfo)
+{
+    UWorld* World = GetWorld();
+    if (!World) return;
+
+    FLatentActionManager& LatentActionManager = World->GetLatentActionManager();
+    if (LatentActionManager.FindExistingAction<FTargetLockLatentAction>(LatentInfo.CallbackTarget, LatentInfo.UUID)) return;
+
+    FTargetLockLatentAction* Action = new FTargetLockLatentAction(LatentInfo, Result, Target);
+    LatentActionManager.AddNewAction(LatentInfo.CallbackTarget, LatentInfo.UUID, Action);
+    Action->Start(this);
+}
+
+void UTargetSystemComponent::ResolvePendingLockResults(AActor* Target)
+{
+    if (PendingLockResults.IsEmpty()) return;
+
+    // Callbacks may start the next async lock, which waits for its own result
+    TArray<FPendingLockResult, TInlineAllocator<1>> Resolved = MoveTemp(PendingLockResults);
+    PendingLockResults.Reset();
+    for (const FPendingLockResult& Pending : Resolved)
+    {
+        Pending.OnResult.ExecuteIfBound(Target);
+    }
+}
+
+void UTargetSystemComponent::FinishTryStartTargetLock()
+{
     NearestTarget = FindNearestTarget(true);
     if (!NearestTarget)
     {
@@ -178,6 +509,10 @@ void UTargetSystemComponent::TryStartTargetLock()
 
 void UTargetSystemComponent::StopTargetLock()
 {
+    CancelVisibilityQuery();
+    CancelPendingTargetQuery();
+    UnbindTargetInvalidation();
+    VisibilityCache.RemoveExpired(GetWorld()->GetTimeSeconds(), LineOfSightCacheMaxAge);
     SetupLocalPlayerController();
 
     bTargetLocked = false;
@@ -192,36 +527,50 @@ void UTargetSystemComponent::StopTargetLock()
         }
     }
     PotentialTargets.Empty();
+    ResetSwitchSlots();
 
     NearestTarget = nullptr;
+    CurrentTargetPointIndex = INDEX_NONE;
 
     MessageFinishTargetLock();
 }
 
 void UTargetSystemComponent::SwitchTarget(FVector2D AxisValue)
 {
+    TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_SwitchTarget);
+    TARGETSYSTEM_TRACE_OBJECT_SCOPE(OwnerActor);
+
     if (!CanSwitchTarget(AxisValue)) return;
     if (TrySwitchBetweenTargetPoints(AxisValue)) return;
     if (PotentialTargets.Num() <= 1) return;
     if (bIsSwitchingTarget) return;
+    if (TrySwitchToPrecomputedTarget(AxisValue)) return;
 
-    TArray<TargetInterface> ActorsToLook;
-    FHitResult Hit;
-
-    for (TargetInterface Interface : PotentialTargets)
+    if (VisibilityTraceMode == ETargetVisibilityTraceMode::Asynchronous)
     {
-        if(!LineTrace(GetOwner()->GetActorLocation(),  GetTargetOwnerLocation(Interface), Hit)) continue;
-        if (!IsInViewport(Interface)) continue;
+        if (VisibilityQuery.Type == EVisibilityQueryType::Switch) return;
 
-        ActorsToLook.Add(Interface);
+        StartVisibilityQuery(EVisibilityQueryType::Switch, AxisValue);
+        return;
     }
 
-    const TargetInterface NewTarget = FMath::Abs(AxisValue.X) > FMath::Abs(AxisValue.Y)  ?
-        FindByHorizontal(ActorsToLook, AxisValue.X) :
-        FindByVertical(ActorsToLook, AxisValue);
+    FinishSwitchTarget(AxisValue);
+}
+
+void UTargetSystemComponent::FinishSwitchTarget(const FVector2D& AxisValue)
+{
+    if (!IsLocked()) return;
 
+    CaptureViewSnapshot();
+
+    const TargetInterface NewTarget = FindSwitchTarget(AxisValue);
     if (!NewTarget) return;
 
+    SwitchToTarget(NewTarget);
+}
+
+void UTargetSystemComponent::SwitchToTarget(const TargetInterface& NewTarget)
+{
     bIsSwitchingTarget = true;
 
     StopObservingTarget();
@@ -231,7 +580,92 @@ void UTargetSystemComponent::SwitchTarget(FVector2D AxisValue)
     ResetIsSwitchingTarget();
 }
 
+bool UTargetSystemComponent::TrySwitchToPrecomputedTarget(const FVector2D& AxisValue)
+{
+    if (!bPrecomputeSwitchTargets || !IsLocked()) return false;
+
+    CaptureViewSnapshot();
+
+    const TargetInterface NewTarget = FindPrecomputedSwitchTarget(AxisValue);
+    if (!NewTarget)
+    {
+        INC_DWORD_STAT(STAT_TargetSystemPrecomputedSwitchMisses);
+        return false;
+    }
+
+    INC_DWORD_STAT(STAT_TargetSystemPrecomputedSwitches);
+    SwitchToTarget(NewTarget);
+    return true;
+}
+
+TScriptInterface<ITargetSystemInterface> UTargetSystemComponent::FindPrecomputedSwitchTarget(const FVector2D& AxisValue)
+{
+    const TargetInterface Target(SwitchSlotTargets[TargetSystemCore::GetSwitchSlot(AxisValue.X, AxisValue.Y)].Get());
+    return IsValidSwitchTarget(Target, AxisValue) ? Target : nullptr;
+}
+
+bool UTargetSystemComponent::IsValidSwitchTarget(const TargetInterface& Interface, const FVector2D& AxisValue) const
+{
+    if (!Interface || !ObjectIsTargetable(Interface)) return false;
+
+    // The same checks as the full search, on this one target only
+    TargetSystemCore::FSwitchCandidate Candidate;
+    if (!MakeSwitchCandidate(Interface, 0, NearestTarget->GetTargetSystemDependencies()->GetOwner(), Candidate)) return false;
+
+    return TargetSystemCore::FindSwitchTarget(
+        &Candidate, 1, AxisValue.X, AxisValue.Y,
+        MaximumDistanceCanStartTarget, GetDistanceFromTarget(NearestTarget)) != INDEX_NONE;
+}
+
+void UTargetSystemComponent::UpdateSwitchSlots()
+{
+    if (PotentialTargets.Num() <= 1) return;
+
+    TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_UpdateSwitchSlots);
+
+    if (SwitchSweepIndex == 0)
+    {
+        CaptureViewSnapshot();
+        SwitchSlotsInProgress.Reset();
+        SwitchSweepTargetDistance = GetDistanceFromTarget(NearestTarget);
+    }
+
+    const AActor* CurrentTargetActor = NearestTarget->GetTargetSystemDependencies()->GetOwner();
+    const int32 SweepEnd = FMath::Min(SwitchSweepIndex + FMath::Max(SwitchCandidatesPerFrame, 1), PotentialTargets.Num());
+    for (; SwitchSweepIndex < SweepEnd; ++SwitchSweepIndex)
+    {
+        TargetSystemCore::FSwitchCandidate Candidate;
+        if (!MakeSwitchCandidate(PotentialTargets[SwitchSweepIndex], SwitchSweepIndex, CurrentTargetActor, Candidate)) continue;
+
+        INC_DWORD_STAT(STAT_TargetSystemCandidatesConsidered);
+        TargetSystemCore::AddSwitchCandidate(SwitchSlotsInProgress, Candidate, MaximumDistanceCanStartTarget, SwitchSweepTargetDistance);
+    }
+    if (SwitchSweepIndex < PotentialTargets.Num()) return;
+
+    for (int32 Slot = 0; Slot < TargetSystemCore::NumSwitchSlots; ++Slot)
+    {
+        const int32 Index = SwitchSlotsInProgress.Index[Slot];
+        SwitchSlotTargets[Slot] = PotentialTargets.IsValidIndex(Index) ? PotentialTargets[Index].GetObject() : nullptr;
+    }
+    SwitchSweepIndex = 0;
+}
+
+void UTargetSystemComponent::ResetSwitchSlots()
+{
+    SwitchSlotsInProgress.Reset();
+    for (TWeakObjectPtr<UObject>& SwitchSlotTarget : SwitchSlotTargets)
+    {
+        SwitchSlotTarget.Reset();
+    }
+    SwitchSweepIndex = 0;
+}
+
 void UTargetSystemComponent::AutoSwitchTarget()
+{
+    RequestTargetQuery(&UTargetSystemComponent::FinishAutoSwitchTarget, false);
+}
+
+void UTargetSystemComponent::FinishAutoSwitchTarget()
 {
     const TScriptInterface<ITargetSystemInterface> NewTarget = FindNearestTarget();
     if (!NewTarget)
@@ -246,108 +680,153 @@ void UTargetSystemComponent::AutoSwitchTarget()
     ResetIsSwitchingTarget();
 }
 
-bool UTargetSystemComponent::TrySwitchBetweenTargetPoints(FVector2D AxisValue)
+void UTargetSystemComponent::RequestTargetQuery(const FTargetQuery Query, const bool bIsLockQuery)
 {
-    if (!NearestTarget) return false;
-    if (GetTargetDetails(NearestTarget).TargetPoints.Num() <= 1) return false;
-    if (bIsSwitchingTarget) return false;
-
-    FString NewCurrentTargetPointName = "None";
-    const int32 MaxIndex = GetTargetDetails(NearestTarget).TargetPoints.Num() - 1;
-    const float MajorAxis = FMath::Abs(AxisValue.X) > FMath::Abs(AxisValue.Y) ? AxisValue.X : AxisValue.Y;
+    PendingTargetQuery = Query;
 
-     const float RangeMin = NearestTarget->GetTargetSystemDependencies()->GetOwner()->GetActorRotation().Yaw - 90.f;
-     const float RangeMax = NearestTarget->GetTargetSystemDependencies()->GetOwner()->GetActorRotation().Yaw + 90.f;
+    UTargetSystemManager* TargetSystemManager = UTargetSystemManager::Get(GetWorld());
+    if (!TargetSystemManager)
+    {
+        RunPendingTargetQuery();
+        return;
+    }
 
-    const int32 SwitchDirection = OwnerActor->GetActorRotation().Yaw > RangeMin && OwnerActor->GetActorRotation().Yaw < RangeMax ?
-          MajorAxis > 0.f ? 1 : -1:
-          MajorAxis > 0.f ? -1 : 1;
+    const ETargetSystemQueryPriority Priority = bIsLockQuery ? ETargetSystemQueryPriority::Lock : ETargetSystemQueryPriority::AutoSwitch;
+    if (!TargetSystemManager->RunOrQueueQuery(this, Priority, FSimpleDelegate::CreateUObject(this, &UTargetSystemComponent::RunPendingTargetQuery)))
+    {
+        // Keeps the manager ticking this lock so it resumes once the query completed
+        RequestManagerTick();
+    }
+}
 
+void UTargetSystemComponent::RunPendingTargetQuery()
+{
+    const FTargetQuery Query = PendingTargetQuery;
+    PendingTargetQuery = nullptr;
 
-    int32 CurrentIndex = 0;
-    for (int32 i = 0; i < GetTargetDetails(NearestTarget).TargetPoints.Num(); ++i)
+    if (Query)
     {
-        if (GetTargetDetails(NearestTarget).TargetPoints[i]->GetName() == CurrentSocketOnNearestTarget)
-        {
-            CurrentIndex = i; break;
-        }
+        (this->*Query)();
     }
+}
 
-    const int32 NewIndex = CurrentIndex + SwitchDirection;
-    if (NewIndex > MaxIndex || NewIndex < 0) return false;
+void UTargetSystemComponent::CancelPendingTargetQuery()
+{
+    if (!PendingTargetQuery) return;
 
-   CurrentSocketOnNearestTarget = GetTargetDetails(NearestTarget).TargetPoints[NewIndex]->GetName();
-    if (TargetLockedOnWidgetComponent)
+    PendingTargetQuery = nullptr;
+    if (UTargetSystemManager* TargetSystemManager = UTargetSystemManager::Get(GetWorld()))
     {
-        TargetLockedOnWidgetComponent->DestroyComponent();
+        TargetSystemManager->CancelQueries(this);
     }
-    CreateAndAttachTargetLockedOnWidgetComponent(NearestTarget);
+}
+
+bool UTargetSystemComponent::TrySwitchBetweenTargetPoints(FVector2D AxisValue)
+{
+    if (!NearestTarget) return false;
+    const TArray<UBTargetPoint*>& TargetPoints = GetTargetDetails(NearestTarget).TargetPoints;
+    if (TargetPoints.Num() <= 1) return false;
+    if (bIsSwitchingTarget) return false;
+
+    const int32 CurrentIndex = TargetPoints.IsValidIndex(CurrentTargetPointIndex) ? CurrentTargetPointIndex : 0;
+    const int32 NewIndex = TargetSystemCore::GetTargetPointSwitchIndex(
+        CurrentIndex, TargetPoints.Num(), AxisValue.X, AxisValue.Y,
+        OwnerActor->GetActorRotation().Yaw, NearestTarget->GetTargetSystemDependencies()->GetOwner()->GetActorRotation().Yaw);
+    if (NewIndex == INDEX_NONE) return false;
+
+    CurrentTargetPointIndex = NewIndex;
+    CurrentSocketOnNearestTarget = TargetPoints[NewIndex]->GetName();
+    AttachTargetLockedOnWidgetComponent(NearestTarget);
     bIsSwitchingTarget = true;
     ResetIsSwitchingTarget();
     return true;
 }
 
-TScriptInterface<ITargetSystemInterface> UTargetSystemComponent::FindByHorizontal(TArray<TargetInterface> LookTargets, float AxisValue) const
+TScriptInterface<ITargetSystemInterface> UTargetSystemComponent::FindSwitchTarget(const FVector2D& AxisValue)
 {
-    TScriptInterface<ITargetSystemInterface> NewNearestTarget = nullptr;
-
-    float MinDistance = MaximumDistanceCanStartTarget;
-    const float RangeMin = AxisValue < 0 ? 0 : 180;
-    const float RangeMax = AxisValue < 0 ? 180 : 360;
+    const AActor* CurrentTargetActor = NearestTarget->GetTargetSystemDependencies()->GetOwner();
 
-    for (TScriptInterface<ITargetSystemInterface> Interface : LookTargets)
+    TArray<TargetSystemCore::FSwitchCandidate>& Candidates = SwitchCandidateScratch;
+    Candidates.Reset(PotentialTargets.Num());
+    if (UTargetSystemManager::ShouldEvaluateInParallel(PotentialTargets.Num()))
     {
-        if (NearestTarget == Interface) continue;
-        const float Angle = GetAngleUsingCameraRotation(GetTargetOwnerLocation(Interface));
-        if (Angle < RangeMin || Angle > RangeMax) continue;
-
-        const float Distance = GetDistanceFromTarget(Interface);
-        if (Distance > MaximumDistanceCanStartTarget) continue;
+        GatherSwitchCandidatesInParallel(CurrentTargetActor);
+    }
+    else
+    {
+        for (int32 i = 0; i < PotentialTargets.Num(); ++i)
+        {
+            TargetSystemCore::FSwitchCandidate Candidate;
+            if (MakeSwitchCandidate(PotentialTargets[i], i, CurrentTargetActor, Candidate))
+            {
+                Candidates.Add(Candidate);
+            }
+        }
+    }
+    INC_DWORD_STAT_BY(STAT_TargetSystemCandidatesConsidered, Candidates.Num());
 
-        const float RelativeActorsDistance = NearestTarget->GetTargetSystemDependencies()->GetOwner()->GetDistanceTo(Interface->GetTargetSystemDependencies()->GetOwner());
-        if (RelativeActorsDistance > MinDistance) continue;
+    const int32 Index = TargetSystemCore::FindSwitchTarget(
+        Candidates.GetData(), Candidates.Num(), AxisValue.X, AxisValue.Y,
+        MaximumDistanceCanStartTarget, GetDistanceFromTarget(NearestTarget));
 
-        MinDistance = RelativeActorsDistance;
-        NewNearestTarget = Interface;
-    }
-    return NewNearestTarget;
+    return Index != INDEX_NONE ? PotentialTargets[Index] : nullptr;
 }
 
-TScriptInterface<ITargetSystemInterface> UTargetSystemComponent::FindByVertical(TArray<TargetInterface> LookTargets, FVector2D AxisValue) const
+void UTargetSystemComponent::GatherSwitchCandidatesInParallel(const AActor* CurrentTargetActor)
 {
-    TScriptInterface<ITargetSystemInterface> NewNearestTarget = nullptr;
-
-    float MinDistance = MaximumDistanceCanStartTarget;
-
-    const float RangeMin = AxisValue.X < 0.f ? 0 : 180;
-    const float RangeMax = AxisValue.X < 0.f ? 180 : 360;
+    TArray<TargetSystemCore::FSwitchCandidate>& Evaluated = SwitchEvaluationScratch;
+    TArray<FVector>& Locations = CandidateLocationScratch;
+    TArray<bool>& InViewport = CandidateInViewportScratch;
 
-    for (TScriptInterface<ITargetSystemInterface> Interface : LookTargets)
+    Evaluated.Reset(PotentialTargets.Num());
+    Locations.Reset(PotentialTargets.Num());
+    for (int32 i = 0; i < PotentialTargets.Num(); ++i)
     {
-        if (NearestTarget == Interface) continue;
-
-        const float Angle = GetAngleUsingCameraRotation(Interface->GetTargetSystemDependencies()->GetOwner()->GetActorLocation());
-        if (Angle < RangeMin || Angle > RangeMax) continue;
+        const TargetInterface& Interface = PotentialTargets[i];
+        if (!Interface || Interface == NearestTarget) continue;
 
-        const float Distance = GetDistanceFromTarget(Interface);
-        if (Distance > MaximumDistanceCanStartTarget) continue;
-
-        const float RelativeActorsDistance = NearestTarget->GetTargetSystemDependencies()->GetOwner()->GetDistanceTo(Interface->GetTargetSystemDependencies()->GetOwner());
-        if (RelativeActorsDistance > MinDistance) continue;
+        Evaluated.Add({i});
+        Locations.Add(GetTargetOwnerLocation(Interface));
+    }
+    InViewport.SetNumUninitialized(Evaluated.Num());
 
-        if (AxisValue.Y < 0.f)
-        {
-            if (GetDistanceFromTarget(Interface) < GetDistanceFromTarget(NearestTarget)) continue;
-        }
-        else
-        {
-            if (GetDistanceFromTarget(Interface) > GetDistanceFromTarget(NearestTarget)) continue;
-        }
+    // The view math of MakeSwitchCandidate, on the snapshotted locations
+    const FTargetSystemViewSnapshot& View = ViewSnapshot;
+    const FVector OwnerLocation = OwnerActor->GetActorLocation();
+    const FVector CurrentTargetLocation = CurrentTargetActor->GetActorLocation();
+    ParallelFor(Evaluated.Num(), [&](const int32 i)
+    {
+        const FVector& Location = Locations[i];
+        InViewport[i] = View.IsInViewport(Location);
+        Evaluated[i].Angle = View.GetYawAngle(Location);
+        Evaluated[i].Distance = static_cast<float>((OwnerLocation - Location).Size());
+        Evaluated[i].DistanceToCurrentTarget = static_cast<float>((CurrentTargetLocation - Location).Size());
+    });
+
+    // Line of sight traces stay on the game thread, in the serial order
+    for (int32 i = 0; i < Evaluated.Num(); ++i)
+    {
+        if (!InViewport[i] || !HasLineOfSight(PotentialTargets[Evaluated[i].Index])) continue;
 
-        MinDistance = RelativeActorsDistance;
-        NewNearestTarget = Interface;
+        SwitchCandidateScratch.Add(Evaluated[i]);
     }
-    return NewNearestTarget;
+}
+
+bool UTargetSystemComponent::MakeSwitchCandidate(
+    const TargetInterface& Interface, const int32 Index, const AActor* CurrentTargetActor, TargetSystemCore::FSwitchCandidate& OutCandidate) const
+{
+    if (!Interface || Interface == NearestTarget) return false;
+    if (!IsInViewport(Interface)) return false;
+    if (!HasLineOfSight(Interface)) return false;
+
+    const AActor* TargetActor = Interface->GetTargetSystemDependencies()->GetOwner();
+    OutCandidate = {
+        Index,
+        GetAngleUsingCameraRotation(TargetActor->GetActorLocation()),
+        GetDistanceFromTarget(Interface),
+        CurrentTargetActor->GetDistanceTo(TargetActor)
+    };
+    return true;
 }
 
 AActor* UTargetSystemComponent::GetLockedOnTargetActor() const
@@ -363,59 +842,18 @@ bool UTargetSystemComponent::IsLocked() const
 
 float UTargetSystemComponent::GetAngleUsingCameraRotation(const FVector& Location) const
 {
-    const UCameraComponent* CameraComponent = OwnerActor->FindComponentByClass<UCameraComponent>();
-    if (!IsValid(CameraComponent))
-    {
-        return GetAngleUsingCharacterRotation(Location);
-    }
-
-    const FRotator CameraWorldRotation = CameraComponent->GetComponentRotation();
-    const FRotator LookAtRotation = FindLookAtRotation(CameraComponent->GetComponentLocation(), Location);
-
-    float YawAngle = CameraWorldRotation.Yaw - LookAtRotation.Yaw;
-    if (YawAngle < 0)
-    {
-        YawAngle = YawAngle + 360;
-    }
-
-    return YawAngle;
+    return ViewSnapshot.GetYawAngle(Location);
 }
 
-float UTargetSystemComponent::GetAngleUsingCharacterRotation(const FVector& Location) const
+void UTargetSystemComponent::CaptureViewSnapshot()
 {
-    const FRotator CharacterRotation = OwnerActor->GetActorRotation();
-    const FRotator LookAtRotation = FindLookAtRotation(OwnerActor->GetActorLocation(), Location);
-
-    float YawAngle = CharacterRotation.Yaw - LookAtRotation.Yaw;
-    if (YawAngle < 0)
-    {
-        YawAngle = YawAngle + 360;
-    }
-
-    return YawAngle;
-}
-
-FRotator UTargetSystemComponent::FindLookAtRotation(const FVector Start, const FVector Target)
-{
-	return FRotationMatrix::MakeFromX(Target - Start).Rotator();
+    ViewSnapshot = FTargetSystemViewSnapshot::Capture(OwnerActor, OwnerPlayerController);
 }
 
 void UTargetSystemComponent::ResetIsSwitchingTarget()
 {
-    if (!SwitchingTargetTimerHandle.IsValid())
-    {
-        GetWorld()->GetTimerManager().SetTimer(
-             SwitchingTargetTimerHandle,
-             this,
-             &UTargetSystemComponent::ResetIsSwitchingTarget,
-             bIsSwitchingTarget ? 0.25f : 0.5f,
-             false
-         );
-        return;
-    }
-
-    GetWorld()->GetTimerManager().ClearTimer(SwitchingTargetTimerHandle);
-	bIsSwitchingTarget = false;
+    SwitchCooldownEndTime = GetWorld()->GetTimeSeconds() + (bIsSwitchingTarget ? 0.25f : 0.5f);
+    RequestManagerTick();
 }
 
 bool UTargetSystemComponent::CanSwitchTarget(const FVector2D& AxisValue) const
@@ -423,80 +861,91 @@ bool UTargetSystemComponent::CanSwitchTarget(const FVector2D& AxisValue) const
 	return FMath::Abs(AxisValue.X) >= StartRotatingThreshold || FMath::Abs(AxisValue.Y) >= StartRotatingThreshold;
 }
 
-void UTargetSystemComponent::CreateAndAttachTargetLockedOnWidgetComponent(const TargetInterface Interface)
+UWidgetComponent* UTargetSystemComponent::GetOrCreateTargetLockedOnWidgetComponent()
 {
-    AActor* TargetActor = Interface.GetInterface()->GetTargetSystemDependencies()->GetOwner();
-    if (!IsValid(TargetActor)) return;
-
-    const TArray<UBTargetPoint*> TargetPoints = GetTargetDetails(Interface).TargetPoints;
-    if (TargetPoints.IsEmpty()) return;
-
-    int32 Index = 0;
-    for (int32 i = 0; i < GetTargetDetails(Interface).TargetPoints.Num(); ++i)
-    {
-        if (GetTargetDetails(Interface).TargetPoints[i]->GetName() == CurrentSocketOnNearestTarget)
-        {
-            Index = i;
-            break;
-        }
-    }
+    if (IsValid(TargetLockedOnWidgetComponent)) return TargetLockedOnWidgetComponent;
 
 	if (!LockedOnWidgetClass)
 	{
 		TS_LOG(Error, TEXT("TargetSystemComponent: Cannot get LockedOnWidgetClass, please ensure it is a valid reference in the Component Properties."));
-		return;
+		return nullptr;
 	}
 
-	TargetLockedOnWidgetComponent = NewObject<UWidgetComponent>(TargetActor, MakeUniqueObjectName(TargetActor, UWidgetComponent::StaticClass(), FName("TargetLockOn")));
-	TargetLockedOnWidgetComponent->SetWidgetClass(LockedOnWidgetClass);
-
-	UMeshComponent* MeshComponent = TargetActor->FindComponentByClass<UMeshComponent>();
-	USceneComponent* ParentComponent = MeshComponent ? MeshComponent : TargetActor->GetRootComponent();
+    if (!IsValid(OwnerActor)) return nullptr;
 
-	if (IsValid(OwnerPlayerController))
-	{
-		TargetLockedOnWidgetComponent->SetOwnerPlayer(OwnerPlayerController->GetLocalPlayer());
-	}
+    INC_DWORD_STAT(STAT_TargetSystemLockOnWidgetAllocations);
 
+	TargetLockedOnWidgetComponent = NewObject<UWidgetComponent>(OwnerActor, MakeUniqueObjectName(OwnerActor, UWidgetComponent::StaticClass(), FName("TargetLockOn")));
+	TargetLockedOnWidgetComponent->SetWidgetClass(LockedOnWidgetClass);
 	TargetLockedOnWidgetComponent->ComponentTags.Add(FName("TargetSystem.LockOnWidget"));
 	TargetLockedOnWidgetComponent->SetWidgetSpace(EWidgetSpace::Screen);
-	TargetLockedOnWidgetComponent->SetupAttachment(TargetPoints[Index]);
-	TargetLockedOnWidgetComponent->SetRelativeLocation(LockedOnWidgetRelativeLocation);
 	TargetLockedOnWidgetComponent->SetDrawSize(FVector2D(LockedOnWidgetDrawSize, LockedOnWidgetDrawSize));
-	TargetLockedOnWidgetComponent->SetVisibility(true);
+	TargetLockedOnWidgetComponent->SetVisibility(false);
 	TargetLockedOnWidgetComponent->RegisterComponent();
+
+	return TargetLockedOnWidgetComponent;
 }
 
-void UTargetSystemComponent::AddPotentialTargetsByInterface(const TSubclassOf<AActor>& ActorClass)
+void UTargetSystemComponent::AttachTargetLockedOnWidgetComponent(const TargetInterface& Interface)
 {
-	for (TActorIterator ActorIterator(GetWorld(), ActorClass); ActorIterator; ++ActorIterator)
-	{
-	    TScriptInterface<ITargetSystemInterface> Interface = TScriptInterface<ITargetSystemInterface>(*ActorIterator);
-	    if(!ObjectIsTargetable(Interface)) continue;
+    AActor* TargetActor = Interface.GetInterface()->GetTargetSystemDependencies()->GetOwner();
+    if (!IsValid(TargetActor)) return;
 
-	    if (GetDistanceFromTarget(Interface) > MaximumDistanceToPotentialTargets) continue;
+    const TArray<UBTargetPoint*>& TargetPoints = GetTargetDetails(Interface).TargetPoints;
+    if (TargetPoints.IsEmpty()) return;
 
-        PotentialTargets.Add(Interface);
+    const int32 Index = TargetPoints.IsValidIndex(CurrentTargetPointIndex) ? CurrentTargetPointIndex : 0;
+
+    UWidgetComponent* WidgetComponent = GetOrCreateTargetLockedOnWidgetComponent();
+    if (!WidgetComponent) return;
+
+	if (IsValid(OwnerPlayerController))
+	{
+		WidgetComponent->SetOwnerPlayer(OwnerPlayerController->GetLocalPlayer());
 	}
+
+	WidgetComponent->SetWidgetClass(LockedOnWidgetClass);
+	WidgetComponent->AttachToComponent(TargetPoints[Index], FAttachmentTransformRules::KeepRelativeTransform);
+	WidgetComponent->SetRelativeLocation(LockedOnWidgetRelativeLocation);
+	WidgetComponent->SetVisibility(true);
 }
 
-bool UTargetSystemComponent::ObjectIsTargetable(const TScriptInterface<ITargetSystemInterface> Actor) const
+void UTargetSystemComponent::HideTargetLockedOnWidgetComponent()
 {
-    if(!Actor) return false;
-    return GetTargetDetails(Actor).bCouldBeTarget;
+    if (!IsValid(TargetLockedOnWidgetComponent)) return;
+
+    // Detach so the pooled widget does not follow the previous target's lifetime
+    TargetLockedOnWidgetComponent->SetVisibility(false);
+    TargetLockedOnWidgetComponent->DetachFromComponent(FDetachmentTransformRules::KeepRelativeTransform);
 }
 
-int32 UTargetSystemComponent::GetPointIndexByName(const FString& Name) const
+void UTargetSystemComponent::AddPotentialTargetsByInterface(const TSubclassOf<AActor>& ActorClass)
 {
-    constexpr int32 InvalidIndex = -1;
-    if (!NearestTarget) return InvalidIndex;
-    for (int32 i = 0; i < GetTargetDetails(NearestTarget).TargetPoints.Num(); ++i)
+    TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_GatherPotentialTargets);
+
+    const UTargetSystemSubsystem* TargetSystemSubsystem = UTargetSystemSubsystem::Get(GetWorld());
+    if (!TargetSystemSubsystem) return;
+
+    TArray<UTargetSystemDependencies*> NearbyTargetables;
+    TargetSystemSubsystem->QueryTargetablesInRadius(OwnerActor->GetActorLocation(), MaximumDistanceToPotentialTargets, NearbyTargetables);
+
+    const UClass* Class = ActorClass ? ActorClass.Get() : AActor::StaticClass();
+    for (const UTargetSystemDependencies* Dependencies : NearbyTargetables)
     {
-        if (GetTargetDetails(NearestTarget).TargetPoints[i]->GetName() != Name) continue;
+        AActor* Actor = Dependencies->GetOwner();
+        if (!IsValid(Actor) || !Actor->IsA(Class)) continue;
 
-        return i;
+        TScriptInterface<ITargetSystemInterface> Interface = TScriptInterface<ITargetSystemInterface>(Actor);
+        if(!ObjectIsTargetable(Interface)) continue;
+
+        PotentialTargets.Add(Interface);
     }
-    return InvalidIndex;
+}
+
+bool UTargetSystemComponent::ObjectIsTargetable(const TScriptInterface<ITargetSystemInterface> Actor) const
+{
+    if(!Actor) return false;
+    return GetTargetDetails(Actor).bCouldBeTarget;
 }
 
 void UTargetSystemComponent::SetupLocalPlayerController()
@@ -510,76 +959,183 @@ void UTargetSystemComponent::SetupLocalPlayerController()
 	OwnerPlayerController = Cast<APlayerController>(OwnerPawn->GetController());
 }
 
-void UTargetSystemComponent::SortPotentialTargetsByDistance(TArray<TScriptInterface<ITargetSystemInterface>>& Array)
+TScriptInterface<ITargetSystemInterface> UTargetSystemComponent::FindNearestTarget(bool bUseAngle)
 {
-    if (Array.IsEmpty()) return;
+    TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_FindNearestTarget);
 
-    Array.Sort([this](const TScriptInterface<ITargetSystemInterface> A, const TScriptInterface<ITargetSystemInterface> B)
+    if (PotentialTargets.IsEmpty()) return nullptr;
+    CaptureViewSnapshot();
+
+    TArray<TargetSystemCore::FTargetCandidate>& Candidates = CandidateScratch;
+    Candidates.Reset(PotentialTargets.Num());
+    if (UTargetSystemManager::ShouldEvaluateInParallel(PotentialTargets.Num()))
+    {
+        // Same distances as GetDistanceFromTarget, from locations read on the game thread
+        TArray<FVector>& Locations = CandidateLocationScratch;
+        Locations.Reset(PotentialTargets.Num());
+        for (int32 i = 0; i < PotentialTargets.Num(); ++i)
         {
-            return GetDistanceFromTarget(A) < GetDistanceFromTarget(B);
+            if (!PotentialTargets[i]) continue;
+
+            Candidates.Add({i, 0.f});
+            Locations.Add(GetTargetOwnerLocation(PotentialTargets[i]));
         }
-    );
+
+        const FVector OwnerLocation = OwnerActor->GetActorLocation();
+        ParallelFor(Candidates.Num(), [&Candidates, &Locations, OwnerLocation](const int32 i)
+        {
+            Candidates[i].Distance = static_cast<float>((OwnerLocation - Locations[i]).Size());
+        });
+    }
+    else
+    {
+        for (int32 i = 0; i < PotentialTargets.Num(); ++i)
+        {
+            if (!PotentialTargets[i]) continue;
+
+            Candidates.Add({i, GetDistanceFromTarget(PotentialTargets[i])});
+        }
+    }
+    INC_DWORD_STAT_BY(STAT_TargetSystemCandidatesConsidered, Candidates.Num());
+
+    TargetSystemCore::FNearestTargetParams Params;
+    Params.MaximumDistance = MaximumDistanceCanStartTarget;
+    Params.DangerousDistance = DangerousDistanceToTarget;
+    Params.MaximumAngle = MaximumFindAngle;
+    Params.ExtraDistanceByAngle = ExtraDistanceToLimitWhenSearchingByAngle;
+
+    const int32 Index = (this->*FindNearestTargetIndexFuncs[bUseAngle ? 1 : 0])(Candidates, Params);
+
+    return Index != INDEX_NONE ? PotentialTargets[Index] : nullptr;
 }
 
-void UTargetSystemComponent::SortPotentialTargetsByAngle(TArray<TScriptInterface<ITargetSystemInterface>>& Array)
+template <TargetSystemCore::ENearestTargetPolicy Policy>
+int32 UTargetSystemComponent::FindNearestTargetIndex(
+    TArray<TargetSystemCore::FTargetCandidate>& Candidates, const TargetSystemCore::FNearestTargetParams& Params)
 {
-    if (Array.IsEmpty()) return;
+    return TargetSystemCore::FindNearestTargetWithPolicy<Policy>(Candidates.GetData(), Candidates.Num(), Params,
+        [this](const int32 i) { return IsInViewport(PotentialTargets[i]); },
+        [this](const int32 i) { return HasLineOfSight(PotentialTargets[i]); },
+        [this](const int32 i) { return GetAngleUsingCameraRotation(GetTargetOwnerLocation(PotentialTargets[i])); });
+}
 
-    Array.Sort([this](const TScriptInterface<ITargetSystemInterface> A, const TScriptInterface<ITargetSystemInterface> B)
-        {
-            return GetAngleUsingCameraRotation(GetTargetOwnerLocation(A)) < GetAngleUsingCameraRotation(GetTargetOwnerLocation(B));
-        }
-    );
+template <TargetSystemCore::ETargetPitchMode PitchMode>
+FRotator UTargetSystemComponent::GetTargetRotation(const TargetInterface& Interface, const FRotator& LookRotation, const double Roll) const
+{
+    if constexpr (PitchMode == TargetSystemCore::PitchMode_Curve)
+    {
+        const float Distance = GetDistanceFromTarget(Interface);
+        const TArray<UBTargetPoint*>& TargetPoints = GetTargetDetails(Interface).TargetPoints;
+        const UCurveFloat* PointPitch = TargetPoints.IsValidIndex(CurrentTargetPointIndex) ? TargetPoints[CurrentTargetPointIndex]->GetPitchOffsetCurve() : nullptr;
+        const UCurveFloat* CurvePitch = IsValid(PointPitch) ? PointPitch : DefaultPitchOffsetCurve;
+
+        const float CurveValue = IsValid(CurvePitch) ? CurvePitch->GetFloatValue(Distance) : 0.f;
+        return FRotator(CurveValue, LookRotation.Yaw, Roll);
+    }
+    else if constexpr (PitchMode == TargetSystemCore::PitchMode_Linear)
+    {
+        const float DistanceToTarget = GetDistanceFromTarget(Interface);
+        const float PitchOffset = TargetSystemCore::GetLinearPitchOffset(
+            DistanceToTarget, PitchDistanceCoefficient, PitchDistanceOffset, PitchMin, PitchMax);
+
+        return FRotator(LookRotation.Pitch + PitchOffset, LookRotation.Yaw, Roll);
+    }
+    else
+    {
+        return FRotator(LookRotation.Pitch, LookRotation.Yaw, Roll);
+    }
 }
 
-TScriptInterface<ITargetSystemInterface> UTargetSystemComponent::FindNearestTarget(bool bUseAngle)
+void UTargetSystemComponent::UpdatePolicies()
 {
-    if (PotentialTargets.IsEmpty()) return nullptr;
-    SortPotentialTargetsByDistance(PotentialTargets);
+    using namespace TargetSystemCore;
 
-    TArray<TScriptInterface<ITargetSystemInterface>> CopyPotentialTargets = {};
-    bool bFindNearestTarget = false;
-    int32 BestTargetByDistance_Index = -1;
+    if (bIgnoreViewport)
+    {
+        FindNearestTargetIndexFuncs[0] = &UTargetSystemComponent::FindNearestTargetIndex<NearestPolicy_DistanceOnly>;
+        FindNearestTargetIndexFuncs[1] = &UTargetSystemComponent::FindNearestTargetIndex<NearestPolicy_DistanceOnly>;
+    }
+    else
+    {
+        FindNearestTargetIndexFuncs[0] = &UTargetSystemComponent::FindNearestTargetIndex<NearestPolicy_ScreenWeighted>;
+        FindNearestTargetIndexFuncs[1] = &UTargetSystemComponent::FindNearestTargetIndex<NearestPolicy_DistanceAngle>;
+    }
 
-    for (int32 i = 0; i < PotentialTargets.Num(); ++i)
+    switch (GetTargetPitchMode(bAdjustPitchBasedOnDistanceToTarget, bAdjustPitchBasedOnDistanceToTargetUsingCurve))
     {
-        FHitResult Hit;
-        if(!LineTrace(GetOwner()->GetActorLocation(), GetTargetOwnerLocation(PotentialTargets[i]), Hit)) continue;
+    case PitchMode_Curve:
+        GetTargetRotationFunc = &UTargetSystemComponent::GetTargetRotation<PitchMode_Curve>;
+        break;
+    case PitchMode_Linear:
+        GetTargetRotationFunc = &UTargetSystemComponent::GetTargetRotation<PitchMode_Linear>;
+        break;
+    default:
+        GetTargetRotationFunc = &UTargetSystemComponent::GetTargetRotation<PitchMode_None>;
+        break;
+    }
+}
 
-        const float Distance = GetDistanceFromTarget(PotentialTargets[i]);
+bool UTargetSystemComponent::LineTrace(const FVector& Start, const FVector& End, FHitResult& Hit) const
+{
+    TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_LineTrace);
+    INC_DWORD_STAT(STAT_TargetSystemTracesIssued);
 
-        if (Distance > MaximumDistanceCanStartTarget) continue;
+    GetWorld()->LineTraceSingleByChannel(
+        Hit,
+        Start,
+        End,
+        TargetCollisionChannel,
+        MakeTraceQueryParams()
+    );
 
-        if (!bIgnoreViewport && !IsInViewport(PotentialTargets[i]) && Distance > DangerousDistanceToTarget) continue;
+    return IsTraceHitOnTarget(Hit, End);
+}
 
-        if (!bFindNearestTarget)
+bool UTargetSystemComponent::HasLineOfSight(const TargetInterface& Interface) const
+{
+    if (ResolvedVisibility)
+    {
+        if (const bool* bVisible = ResolvedVisibility->Find(Interface.GetObject()))
         {
-            bFindNearestTarget = true;
-            BestTargetByDistance_Index = i;
+            return *bVisible;
         }
+    }
 
-        if (!bUseAngle) break;
+    const FVector Start = OwnerActor->GetActorLocation();
+    const FVector End = GetTargetOwnerLocation(Interface);
 
-        CopyPotentialTargets.Add(PotentialTargets[i]);
-    }
-    if (BestTargetByDistance_Index < 0) return nullptr;
-    if (!bUseAngle || bIgnoreViewport) return PotentialTargets[BestTargetByDistance_Index];
+    bool bVisible = false;
+    if (FindCachedLineOfSight(Interface.GetObject(), Start, End, bVisible)) return bVisible;
 
-    SortPotentialTargetsByAngle(CopyPotentialTargets);
+    FHitResult Hit;
+    bVisible = LineTrace(Start, End, Hit);
+    CacheLineOfSight(Interface.GetObject(), Start, End, bVisible);
+    return bVisible;
+}
 
-    for (int32 i = 0; i < CopyPotentialTargets.Num(); ++i)
-    {
-        if (GetAngleUsingCameraRotation(GetTargetOwnerLocation(CopyPotentialTargets[i])) > MaximumFindAngle) continue;
+bool UTargetSystemComponent::FindCachedLineOfSight(const UObject* Target, const FVector& Start, const FVector& End, bool& bOutVisible) const
+{
+    if (!bUseLineOfSightCache) return false;
 
-        const float Distance = GetDistanceFromTarget(CopyPotentialTargets[i]);
-        if (GetDistanceFromTarget(PotentialTargets[BestTargetByDistance_Index]) + ExtraDistanceToLimitWhenSearchingByAngle < Distance) continue;
+    return VisibilityCache.Find(
+        Target,
+        Start,
+        End,
+        GetWorld()->GetTimeSeconds(),
+        LineOfSightCacheMaxAge,
+        LineOfSightCacheInvalidationDistance,
+        bOutVisible
+    );
+}
 
-        return CopyPotentialTargets[i];
-    }
-    return PotentialTargets[BestTargetByDistance_Index];
+void UTargetSystemComponent::CacheLineOfSight(const UObject* Target, const FVector& Start, const FVector& End, const bool bVisible) const
+{
+    if (!bUseLineOfSightCache) return;
+
+    VisibilityCache.Store(Target, Start, End, GetWorld()->GetTimeSeconds(), bVisible);
 }
 
-bool UTargetSystemComponent::LineTrace(const FVector& Start, const FVector& End, FHitResult& Hit) const
+FCollisionQueryParams UTargetSystemComponent::MakeTraceQueryParams() const
 {
     FCollisionQueryParams Params;
     Params.AddIgnoredActor(GetOwner());
@@ -591,18 +1147,110 @@ bool UTargetSystemComponent::LineTrace(const FVector& Start, const FVector& End,
         IgnoredActors.Add(ChildActor);
     }
     Params.AddIgnoredActors(IgnoredActors);
-    GetWorld()->LineTraceSingleByChannel(
-        Hit,
-        Start,
-        End,
-        TargetCollisionChannel,
-        Params
-    );
+    return Params;
+}
 
+bool UTargetSystemComponent::IsTraceHitOnTarget(const FHitResult& Hit, const FVector& End)
+{
     return Hit.HitObjectHandle.GetLocation() == End;
 }
 
-FRotator UTargetSystemComponent::GetControlRotationOnTarget(TargetInterface Interface) const
+void UTargetSystemComponent::StartVisibilityQuery(const EVisibilityQueryType Type, const FVector2D& AxisValue)
+{
+    TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_StartVisibilityQuery);
+
+    CancelVisibilityQuery();
+
+    VisibilityQuery.Type = Type;
+    VisibilityQuery.AxisValue = AxisValue;
+
+    const FCollisionQueryParams Params = MakeTraceQueryParams();
+    FTraceDelegate TraceDelegate;
+    TraceDelegate.BindUObject(this, &UTargetSystemComponent::OnVisibilityTraceCompleted);
+
+    const FVector Start = OwnerActor->GetActorLocation();
+    VisibilityQuery.Start = Start;
+    for (const TargetInterface& Interface : PotentialTargets)
+    {
+        if (!Interface) continue;
+
+        const FVector End = GetTargetOwnerLocation(Interface);
+        bool bVisible = false;
+        if (FindCachedLineOfSight(Interface.GetObject(), Start, End, bVisible))
+        {
+            VisibilityQuery.Results.Add(Interface.GetObject(), bVisible);
+            continue;
+        }
+
+        const uint32 UserData = VisibilityQuery.TraceHandles.Num();
+        VisibilityQuery.Targets.Add(Interface.GetObject());
+        VisibilityQuery.TraceHandles.Add(GetWorld()->AsyncLineTraceByChannel(
+            EAsyncTraceType::Single,
+            Start,
+            End,
+            TargetCollisionChannel,
+            Params,
+            FCollisionResponseParams::DefaultResponseParam,
+            &TraceDelegate,
+            UserData
+        ));
+    }
+
+    VisibilityQuery.PendingTraces = VisibilityQuery.TraceHandles.Num();
+    INC_DWORD_STAT_BY(STAT_TargetSystemTracesIssued, VisibilityQuery.PendingTraces);
+    if (VisibilityQuery.PendingTraces == 0)
+    {
+        FinishVisibilityQuery();
+    }
+}
+
+void UTargetSystemComponent::OnVisibilityTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+    const int32 Index = static_cast<int32>(TraceDatum.UserData);
+    if (!VisibilityQuery.TraceHandles.IsValidIndex(Index) || !(VisibilityQuery.TraceHandles[Index] == TraceHandle)) return;
+
+    if (const UObject* Target = VisibilityQuery.Targets[Index].Get())
+    {
+        const bool bVisible = !TraceDatum.OutHits.IsEmpty() && IsTraceHitOnTarget(TraceDatum.OutHits[0], TraceDatum.End);
+        VisibilityQuery.Results.Add(Target, bVisible);
+        CacheLineOfSight(Target, VisibilityQuery.Start, TraceDatum.End, bVisible);
+    }
+
+    if (--VisibilityQuery.PendingTraces > 0) return;
+
+    FinishVisibilityQuery();
+}
+
+void UTargetSystemComponent::FinishVisibilityQuery()
+{
+    TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_FinishVisibilityQuery);
+    TARGETSYSTEM_TRACE_OBJECT_SCOPE(OwnerActor);
+
+    const FVisibilityQuery Query = MoveTemp(VisibilityQuery);
+    VisibilityQuery = FVisibilityQuery();
+
+    ResolvedVisibility = &Query.Results;
+    switch (Query.Type)
+    {
+    case EVisibilityQueryType::Lock:
+        FinishTryStartTargetLock();
+        break;
+    case EVisibilityQueryType::Switch:
+        FinishSwitchTarget(Query.AxisValue);
+        break;
+    default:
+        break;
+    }
+    ResolvedVisibility = nullptr;
+}
+
+void UTargetSystemComponent::CancelVisibilityQuery()
+{
+    // Late trace callbacks are discarded by the handle check in OnVisibilityTraceCompleted
+    VisibilityQuery = FVisibilityQuery();
+}
+
+FRotator UTargetSystemComponent::GetControlRotationOnTarget(const TargetInterface& Interface) const
 {
     if (!Interface) return FRotator::ZeroRotator;
 
@@ -627,39 +1275,15 @@ FRotator UTargetSystemComponent::GetControlRotationOnTarget(TargetInterface Inte
 
 	// Find look at rotation
 	const FRotator LookRotation = FRotationMatrix::MakeFromX(TargetPointLocation - CharacterLocation).Rotator();
-	float Pitch = LookRotation.Pitch;
-	FRotator TargetRotation;
-	if (bAdjustPitchBasedOnDistanceToTargetUsingCurve)
-	{
-		const float Distance = GetDistanceFromTarget(Interface);
-        const int32 Index = GetPointIndexByName(CurrentSocketOnNearestTarget);
-	    const UCurveFloat* CurvePitch = Index >= 0 && IsValid(GetTargetDetails(Interface).TargetPoints[Index]->GetPitchOffsetCurve()) ?
-	            GetTargetDetails(Interface).TargetPoints[Index]->GetPitchOffsetCurve():
-	            DefaultPitchOffsetCurve;
-
-		const float CurveValue = IsValid(CurvePitch) ? CurvePitch->GetFloatValue(Distance) : 0.f;
-		TargetRotation = FRotator(CurveValue, LookRotation.Yaw, ControlRotation.Roll);
-	}
-	else if (bAdjustPitchBasedOnDistanceToTarget)
-	{
-		const float DistanceToTarget = GetDistanceFromTarget(Interface);
-		const float PitchInRange = (DistanceToTarget * PitchDistanceCoefficient + PitchDistanceOffset) * -1.0f;
-		const float PitchOffset = FMath::Clamp(PitchInRange, PitchMin, PitchMax);
-
-		Pitch = Pitch + PitchOffset;
-		TargetRotation = FRotator(Pitch, LookRotation.Yaw, ControlRotation.Roll);
-	}
-	else
-	{
-	    TargetRotation = FRotator(Pitch, LookRotation.Yaw, ControlRotation.Roll);
-	}
+	const FRotator TargetRotation = (this->*GetTargetRotationFunc)(Interface, LookRotation, ControlRotation.Roll);
 
 	return FMath::RInterpTo(ControlRotation, TargetRotation, GetWorld()->GetDeltaSeconds(), 9.0f);
 }
 
-FTargetActorDetails UTargetSystemComponent::GetTargetDetails(const TargetInterface& Interface) const
+const FTargetActorDetails& UTargetSystemComponent::GetTargetDetails(const TargetInterface& Interface) const
 {
-    if (!Interface) return {};
+    static const FTargetActorDetails EmptyDetails;
+    if (!Interface) return EmptyDetails;
     return Interface->GetTargetSystemDependencies()->GetTargetActorDetails();
 }
 
@@ -671,6 +1295,8 @@ FVector UTargetSystemComponent::GetTargetOwnerLocation(const TargetInterface& In
 
 void UTargetSystemComponent::SetControlRotationOnTarget() const
 {
+    TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_SetControlRotationOnTarget);
+
 	if (!IsValid(OwnerPlayerController)) return;
     if (!NearestTarget) return;
 
@@ -704,13 +1330,5 @@ void UTargetSystemComponent::ControlRotation(const bool ShouldControlRotation) c
 
 bool UTargetSystemComponent::IsInViewport(TargetInterface Interface) const
 {
-	if (!IsValid(OwnerPlayerController)) return true;
-
-	FVector2D ScreenLocation;
-	OwnerPlayerController->ProjectWorldLocationToScreen(GetTargetOwnerLocation(Interface), ScreenLocation);
-
-	FVector2D ViewportSize;
-	GetWorld()->GetGameViewport()->GetViewportSize(ViewportSize);
-
-	return ScreenLocation.X > 10.f && ScreenLocation.Y > 10.f && ScreenLocation.X < ViewportSize.X && ScreenLocation.Y < ViewportSize.Y;
+	return ViewSnapshot.IsInViewport(GetTargetOwnerLocation(Interface));
 }
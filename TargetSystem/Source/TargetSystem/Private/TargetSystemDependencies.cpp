@@ -6,6 +6,72 @@
 
 #include "BTargetPoint.h"
 #include "TargetSystemLog.h"
+#include "TargetSystemSubsystem.h"
+
+void UTargetSystemDependencies::BeginPlay()
+{
+    Super::BeginPlay();
+
+    // Gathered like before the registry, on bCouldBeTarget alone; SetIsTargetable(false) and NotifyDied take the owner out
+    if (!TargetActorDetails.bCouldBeTarget) return;
+
+    if (UTargetSystemSubsystem* TargetSystemSubsystem = UTargetSystemSubsystem::Get(GetWorld()))
+    {
+        TargetSystemSubsystem->RegisterTargetable(this);
+    }
+}
+
+void UTargetSystemDependencies::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    // Only a target leaving a world that keeps playing, listeners tear down with the world otherwise
+    if (EndPlayReason == EEndPlayReason::Destroyed || EndPlayReason == EEndPlayReason::RemovedFromWorld)
+    {
+        OnTargetInvalidated.Broadcast(this, ETargetInvalidationReason::EndPlay);
+    }
+
+    if (UTargetSystemSubsystem* TargetSystemSubsystem = UTargetSystemSubsystem::Get(GetWorld()))
+    {
+        TargetSystemSubsystem->UnregisterTargetable(this);
+    }
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void UTargetSystemDependencies::SetIsTargetable(const bool Value)
+{
+    const bool bWasTargetable = TargetActorDetails.bIsTargetable;
+    TargetActorDetails.bIsTargetable = Value;
+    if (!HasBegunPlay()) return;
+
+    if (bWasTargetable && !Value)
+    {
+        OnTargetInvalidated.Broadcast(this, ETargetInvalidationReason::NotTargetable);
+    }
+
+    UTargetSystemSubsystem* TargetSystemSubsystem = UTargetSystemSubsystem::Get(GetWorld());
+    if (!TargetSystemSubsystem) return;
+
+    if (Value && TargetActorDetails.bCouldBeTarget)
+    {
+        TargetSystemSubsystem->RegisterTargetable(this);
+    }
+    else if (!Value)
+    {
+        TargetSystemSubsystem->UnregisterTargetable(this);
+    }
+}
+
+void UTargetSystemDependencies::NotifyDied()
+{
+    TargetActorDetails.bIsTargetable = false;
+
+    if (UTargetSystemSubsystem* TargetSystemSubsystem = UTargetSystemSubsystem::Get(GetWorld()))
+    {
+        TargetSystemSubsystem->UnregisterTargetable(this);
+    }
+
+    OnTargetInvalidated.Broadcast(this, ETargetInvalidationReason::Died);
+}
 
 void UTargetSystemDependencies::SetUp(
     TArray<UBTargetPoint*> _TargetPoints
@@ -43,5 +109,12 @@ void UTargetSystemDependencies::SetUp(
             UE_LOG(LogTargetSystem, Warning, TEXT("StartTargetPointName not specified (%s)"), *this->GetName());
             TargetActorDetails.StartTargetPointName = TargetActorDetails.TargetPoints[0]->GetName();
         }
+
+        TargetActorDetails.StartTargetPointIndex = TargetActorDetails.TargetPoints.IndexOfByPredicate([this](const UBTargetPoint* TargetPoint)
+            {
+                return TargetPoint->GetName() == TargetActorDetails.StartTargetPointName;
+            }
+        );
+        if (TargetActorDetails.StartTargetPointIndex == INDEX_NONE) TargetActorDetails.StartTargetPointIndex = 0;
     }
 }
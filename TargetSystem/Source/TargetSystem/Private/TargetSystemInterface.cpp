@@ -3,9 +3,18 @@
 #include "TargetSystemInterface.h"
 
 #include "NextTargetSystemComponent.h"
+#include "TargetSystemDependencies.h"
 
 UNextTargetSystemComponent* ITargetSystemInterface::GetTargetSystemComponent_Implementation() const
 {
 	const AActor* SelfActor = Cast<AActor>(this);
 	return IsValid(SelfActor) ? SelfActor->FindComponentByClass<UNextTargetSystemComponent>() : nullptr;
-}
\ No newline at end of file
+}
+
+void ITargetSystemInterface::NotifyTargetDied()
+{
+	if (UTargetSystemDependencies* Dependencies = GetTargetSystemDependencies())
+	{
+		Dependencies->NotifyDied();
+	}
+}
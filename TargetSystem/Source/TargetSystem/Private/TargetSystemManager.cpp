@@ -0,0 +1,206 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TargetSystemManager.h"
+
+#include "TargetSystemComponent.h"
+#include "TargetSystemStats.h"
+#include "TargetSystemSubsystem.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+
+// Off by default: a deferred lock or auto switch leaves its component on the old target, unchecked, until the query runs
+static TAutoConsoleVariable<float> CVarQueryBudgetUs(
+	TEXT("TargetSystem.QueryBudgetUs"),
+	0.f,
+	TEXT("Microseconds of target queries allowed per frame before further ones are deferred to later frames, 0 disables the budget (default)."));
+
+static TAutoConsoleVariable<int32> CVarParallelCandidateThreshold(
+	TEXT("TargetSystem.ParallelCandidateThreshold"),
+	128,
+	TEXT("Candidate count from which lock, switch and sort task candidates are evaluated with ParallelFor, 0 disables it."));
+
+void FTargetSystemManagerTickFunction::ExecuteTick(
+	const float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (IsValid(Manager))
+	{
+		Manager->Tick(DeltaTime);
+	}
+}
+
+FString FTargetSystemManagerTickFunction::DiagnosticMessage()
+{
+	return TEXT("FTargetSystemManagerTickFunction");
+}
+
+FName FTargetSystemManagerTickFunction::DiagnosticContext(bool bDetailed)
+{
+	return FName(TEXT("TargetSystemManager"));
+}
+
+UTargetSystemManager* UTargetSystemManager::Get(const UWorld* World)
+{
+	return World ? World->GetSubsystem<UTargetSystemManager>() : nullptr;
+}
+
+bool UTargetSystemManager::ShouldEvaluateInParallel(const int32 NumCandidates)
+{
+	const int32 Threshold = CVarParallelCandidateThreshold.GetValueOnGameThread();
+	if (Threshold <= 0 || NumCandidates < Threshold) return false;
+
+	INC_DWORD_STAT(STAT_TargetSystemParallelEvaluations);
+	return true;
+}
+
+void UTargetSystemManager::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	TickFunction.Manager = this;
+	TickFunction.TickGroup = TG_PrePhysics;
+	TickFunction.bCanEverTick = true;
+	TickFunction.bStartWithTickEnabled = true;
+	TickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void UTargetSystemManager::Deinitialize()
+{
+	if (TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.UnRegisterTickFunction();
+	}
+	TickFunction.Manager = nullptr;
+
+	for (const TWeakObjectPtr<UTargetSystemComponent>& Component : ActiveComponents)
+	{
+		if (Component.IsValid())
+		{
+			Component->bTickedByManager = false;
+		}
+	}
+	ActiveComponents.Empty();
+	QueuedQueries.Empty();
+
+	Super::Deinitialize();
+}
+
+void UTargetSystemManager::Tick(float DeltaTime)
+{
+	TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_ManagerTick);
+	SET_DWORD_STAT(STAT_TargetSystemActiveComponents, ActiveComponents.Num());
+
+	// Ahead of the queries and the components, so they see this frame's positions rather than the last one's
+	if (UTargetSystemSubsystem* Registry = UTargetSystemSubsystem::Get(GetWorld()))
+	{
+		Registry->RefreshGrid();
+	}
+
+	RunQueuedQueries();
+
+	// Components registered while ticking are appended and ticked this frame as well
+	for (int32 i = 0; i < ActiveComponents.Num(); ++i)
+	{
+		UTargetSystemComponent* Component = ActiveComponents[i].Get();
+		if (Component && Component->TickTargetSystem(DeltaTime)) continue;
+
+		if (Component)
+		{
+			Component->bTickedByManager = false;
+		}
+		ActiveComponents.RemoveAtSwap(i--);
+	}
+}
+
+void UTargetSystemManager::RegisterActiveComponent(UTargetSystemComponent* Component)
+{
+	if (!IsValid(Component) || Component->bTickedByManager) return;
+
+	Component->bTickedByManager = true;
+	ActiveComponents.Add(Component);
+}
+
+void UTargetSystemManager::UnregisterActiveComponent(UTargetSystemComponent* Component)
+{
+	if (!Component || !Component->bTickedByManager) return;
+
+	Component->bTickedByManager = false;
+	const int32 Index = ActiveComponents.Find(Component);
+	if (Index != INDEX_NONE)
+	{
+		ActiveComponents[Index].Reset();
+	}
+}
+
+bool UTargetSystemManager::RunOrQueueQuery(const UObject* Owner, const ETargetSystemQueryPriority Priority, FSimpleDelegate Query)
+{
+	BeginBudgetFrame();
+
+	// Queries may only skip the queue when they rank above everything already waiting in it
+	const float BudgetUs = CVarQueryBudgetUs.GetValueOnGameThread();
+	const bool bOutranksQueue = QueuedQueries.IsEmpty() || Priority > QueuedQueries.HeapTop().Priority;
+	if (BudgetUs <= 0.f || (bOutranksQueue && BudgetSpentUs < BudgetUs))
+	{
+		RunQuery(Query);
+		return true;
+	}
+
+	QueuedQueries.HeapPush({Owner, Priority, NextQuerySequence++, MoveTemp(Query)}, &UTargetSystemManager::IsQueuedBefore);
+	INC_DWORD_STAT(STAT_TargetSystemQueriesDeferred);
+	return false;
+}
+
+void UTargetSystemManager::CancelQueries(const UObject* Owner)
+{
+	if (QueuedQueries.RemoveAll([Owner](const FQueuedQuery& Queued) { return Queued.Owner == Owner; }) > 0)
+	{
+		QueuedQueries.Heapify(&UTargetSystemManager::IsQueuedBefore);
+	}
+}
+
+bool UTargetSystemManager::IsQueuedBefore(const FQueuedQuery& A, const FQueuedQuery& B)
+{
+	return A.Priority != B.Priority ? A.Priority > B.Priority : A.Sequence < B.Sequence;
+}
+
+void UTargetSystemManager::RunQueuedQueries()
+{
+	BeginBudgetFrame();
+	SET_DWORD_STAT(STAT_TargetSystemQueryQueueDepth, QueuedQueries.Num());
+
+	// At least one queued query runs per frame so a small budget still drains the queue
+	const float BudgetUs = CVarQueryBudgetUs.GetValueOnGameThread();
+	while (!QueuedQueries.IsEmpty())
+	{
+		if (BudgetUs > 0.f && BudgetSpentUs >= BudgetUs && QueriesRunThisFrame > 0) break;
+
+		FQueuedQuery Queued;
+		QueuedQueries.HeapPop(Queued, &UTargetSystemManager::IsQueuedBefore);
+		if (!Queued.Owner.IsValid()) continue;
+
+		RunQuery(Queued.Query);
+	}
+}
+
+void UTargetSystemManager::RunQuery(const FSimpleDelegate& Query)
+{
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	Query.ExecuteIfBound();
+
+	BudgetSpentUs += FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) * 1000.0;
+	++QueriesRunThisFrame;
+}
+
+void UTargetSystemManager::BeginBudgetFrame()
+{
+	if (BudgetFrame == GFrameCounter) return;
+
+	BudgetFrame = GFrameCounter;
+	BudgetSpentUs = 0.0;
+	QueriesRunThisFrame = 0;
+}
+
+bool UTargetSystemManager::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TargetSystemSpatialGrid.h"
+
+FTargetSystemSpatialGrid::FTargetSystemSpatialGrid(const float InCellSize)
+{
+	SetCellSize(InCellSize);
+}
+
+void FTargetSystemSpatialGrid::SetCellSize(const float InCellSize)
+{
+	CellSize = FMath::Max(InCellSize, 1.f);
+	InvCellSize = 1.f / CellSize;
+
+	Cells.Reset();
+	for (int32 i = 0; i < Entries.Num(); ++i)
+	{
+		Entries[i].Cell = GetCell(Entries[i].Location);
+		AddToCell(Entries[i].Cell, i);
+	}
+}
+
+void FTargetSystemSpatialGrid::Add(const FVector& Location)
+{
+	const int32 Index = Entries.Add({Location, GetCell(Location)});
+	AddToCell(Entries[Index].Cell, Index);
+}
+
+void FTargetSystemSpatialGrid::RemoveAtSwap(const int32 Index)
+{
+	if (!Entries.IsValidIndex(Index)) return;
+
+	RemoveFromCell(Entries[Index].Cell, Index);
+
+	const int32 LastIndex = Entries.Num() - 1;
+	if (Index != LastIndex)
+	{
+		TArray<int32>& LastCell = Cells.FindChecked(Entries[LastIndex].Cell);
+		LastCell[LastCell.Find(LastIndex)] = Index;
+	}
+	Entries.RemoveAtSwap(Index);
+}
+
+void FTargetSystemSpatialGrid::Update(const int32 Index, const FVector& Location)
+{
+	FEntry& Entry = Entries[Index];
+	Entry.Location = Location;
+
+	const FIntPoint NewCell = GetCell(Location);
+	if (NewCell == Entry.Cell) return;
+
+	RemoveFromCell(Entry.Cell, Index);
+	AddToCell(NewCell, Index);
+	Entry.Cell = NewCell;
+}
+
+void FTargetSystemSpatialGrid::Reset()
+{
+	Entries.Reset();
+	Cells.Reset();
+}
+
+void FTargetSystemSpatialGrid::QueryRadius(const FVector& Center, const float Radius, TArray<int32>& OutIndices) const
+{
+	if (Radius < 0.f || Entries.IsEmpty()) return;
+
+	const FIntPoint MinCell = GetCell(Center - FVector(Radius, Radius, 0.f));
+	const FIntPoint MaxCell = GetCell(Center + FVector(Radius, Radius, 0.f));
+	const double RadiusSquared = FMath::Square(static_cast<double>(Radius));
+
+	auto VisitCell = [&](const TArray<int32>& Indices)
+	{
+		for (const int32 Index : Indices)
+		{
+			if (FVector::DistSquared(Entries[Index].Location, Center) > RadiusSquared) continue;
+
+			OutIndices.Add(Index);
+		}
+	};
+
+	// Large radius against a sparse grid: walking the occupied cells is cheaper than probing every cell in range
+	const int64 NumCellsInRange = static_cast<int64>(MaxCell.X - MinCell.X + 1) * (MaxCell.Y - MinCell.Y + 1);
+	if (NumCellsInRange > Cells.Num())
+	{
+		for (const TPair<FIntPoint, TArray<int32>>& Cell : Cells)
+		{
+			if (Cell.Key.X < MinCell.X || Cell.Key.X > MaxCell.X || Cell.Key.Y < MinCell.Y || Cell.Key.Y > MaxCell.Y) continue;
+
+			VisitCell(Cell.Value);
+		}
+		return;
+	}
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			if (const TArray<int32>* Indices = Cells.Find(FIntPoint(X, Y)))
+			{
+				VisitCell(*Indices);
+			}
+		}
+	}
+}
+
+FIntPoint FTargetSystemSpatialGrid::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X * InvCellSize), FMath::FloorToInt32(Location.Y * InvCellSize));
+}
+
+void FTargetSystemSpatialGrid::AddToCell(const FIntPoint& Cell, const int32 Index)
+{
+	Cells.FindOrAdd(Cell).Add(Index);
+}
+
+void FTargetSystemSpatialGrid::RemoveFromCell(const FIntPoint& Cell, const int32 Index)
+{
+	TArray<int32>* Indices = Cells.Find(Cell);
+	if (!Indices) return;
+
+	Indices->RemoveSingleSwap(Index);
+	if (Indices->IsEmpty())
+	{
+		Cells.Remove(Cell);
+	}
+}
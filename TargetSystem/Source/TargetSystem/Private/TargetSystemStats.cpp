@@ -0,0 +1,45 @@
+// Copyright (c) 2024 NextGenium
+
+#include "TargetSystemStats.h"
+
+DEFINE_STAT(STAT_TargetSystem_TryStartTargetLock);
+DEFINE_STAT(STAT_TargetSystem_FindNearestTarget);
+DEFINE_STAT(STAT_TargetSystem_GatherPotentialTargets);
+DEFINE_STAT(STAT_TargetSystem_LineTrace);
+DEFINE_STAT(STAT_TargetSystem_StartVisibilityQuery);
+DEFINE_STAT(STAT_TargetSystem_FinishVisibilityQuery);
+DEFINE_STAT(STAT_TargetSystem_SwitchTarget);
+DEFINE_STAT(STAT_TargetSystem_UpdateTargetInfo);
+DEFINE_STAT(STAT_TargetSystem_UpdateSwitchSlots);
+DEFINE_STAT(STAT_TargetSystem_TickComponent);
+DEFINE_STAT(STAT_TargetSystem_SetControlRotationOnTarget);
+DEFINE_STAT(STAT_TargetSystem_ManagerTick);
+DEFINE_STAT(STAT_TargetSystem_RegistryTick);
+DEFINE_STAT(STAT_TargetSystem_RegistryQuery);
+DEFINE_STAT(STAT_TargetSystem_PublishTargetSnapshot);
+DEFINE_STAT(STAT_TargetSystem_TargetingRequest);
+DEFINE_STAT(STAT_TargetSystem_TargetingCompleted);
+DEFINE_STAT(STAT_TargetSystem_SortTaskScore);
+DEFINE_STAT(STAT_TargetSystem_SortTaskBuildBatch);
+DEFINE_STAT(STAT_TargetSystem_RegistrySelectionTask);
+DEFINE_STAT(STAT_TargetSystem_FilterAndSortTask);
+DEFINE_STAT(STAT_TargetSystem_SwitchFilterTask);
+
+DEFINE_STAT(STAT_TargetSystemActiveComponents);
+DEFINE_STAT(STAT_TargetSystemQueryQueueDepth);
+DEFINE_STAT(STAT_TargetSystemQueriesDeferred);
+DEFINE_STAT(STAT_TargetSystemPrecomputedSwitches);
+DEFINE_STAT(STAT_TargetSystemPrecomputedSwitchMisses);
+DEFINE_STAT(STAT_TargetSystemParallelEvaluations);
+DEFINE_STAT(STAT_TargetSystemCandidatesConsidered);
+DEFINE_STAT(STAT_TargetSystemLockChecks);
+DEFINE_STAT(STAT_TargetSystemLockChecksAvoided);
+DEFINE_STAT(STAT_TargetSystemTracesIssued);
+DEFINE_STAT(STAT_TargetSystemLockOnWidgetAllocations);
+DEFINE_STAT(STAT_TargetSystemActiveTargetingRequests);
+DEFINE_STAT(STAT_TargetSystemCancelledTargetingRequests);
+DEFINE_STAT(STAT_TargetSystemCoalescedLockRequests);
+DEFINE_STAT(STAT_TargetSystemTargetSnapshotAllocations);
+DEFINE_STAT(STAT_TargetSystemLockContextAllocations);
+
+UE_TRACE_CHANNEL_DEFINE(TargetSystemChannel);
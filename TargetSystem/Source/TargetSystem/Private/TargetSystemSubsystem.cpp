@@ -0,0 +1,151 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TargetSystemSubsystem.h"
+
+#include "TargetSystemDependencies.h"
+#include "TargetSystemStats.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+UTargetSystemSubsystem* UTargetSystemSubsystem::Get(const UWorld* World)
+{
+	return World ? World->GetSubsystem<UTargetSystemSubsystem>() : nullptr;
+}
+
+void UTargetSystemSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Grid.SetCellSize(GridCellSize);
+
+	TargetSnapshots[0] = MakeShared<FTargetSystemTargetSnapshot, ESPMode::ThreadSafe>();
+	TargetSnapshots[1] = MakeShared<FTargetSystemTargetSnapshot, ESPMode::ThreadSafe>();
+}
+
+void UTargetSystemSubsystem::Deinitialize()
+{
+	Targetables.Empty();
+	TargetableIndices.Empty();
+	Grid.Reset();
+	Super::Deinitialize();
+}
+
+void UTargetSystemSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Worlds whose manager did not tick this frame still get their grid refreshed
+	RefreshGrid();
+}
+
+void UTargetSystemSubsystem::RefreshGrid()
+{
+	if (RefreshedGridFrame == GFrameCounter) return;
+	RefreshedGridFrame = GFrameCounter;
+
+	TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_RegistryTick);
+
+	for (int32 i = Targetables.Num() - 1; i >= 0; --i)
+	{
+		const AActor* Owner = Targetables[i].IsValid() ? Targetables[i]->GetOwner() : nullptr;
+		if (!IsValid(Owner))
+		{
+			RemoveTargetableAt(i);
+			continue;
+		}
+
+		Grid.Update(i, Owner->GetActorLocation());
+	}
+}
+
+TStatId UTargetSystemSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTargetSystemSubsystem, STATGROUP_Tickables);
+}
+
+void UTargetSystemSubsystem::RegisterTargetable(UTargetSystemDependencies* Dependencies)
+{
+	if (!IsValid(Dependencies) || !IsValid(Dependencies->GetOwner())) return;
+	if (TargetableIndices.Contains(Dependencies)) return;
+
+	TargetableIndices.Add(Dependencies, Targetables.Add(Dependencies));
+	Grid.Add(Dependencies->GetOwner()->GetActorLocation());
+}
+
+void UTargetSystemSubsystem::UnregisterTargetable(UTargetSystemDependencies* Dependencies)
+{
+	if (const int32* Index = TargetableIndices.Find(Dependencies))
+	{
+		RemoveTargetableAt(*Index);
+	}
+}
+
+void UTargetSystemSubsystem::QueryTargetablesInRadius(
+	const FVector& Origin, const float Radius, TArray<UTargetSystemDependencies*>& OutTargetables) const
+{
+	TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_RegistryQuery);
+
+	QueryScratch.Reset();
+	Grid.QueryRadius(Origin, Radius, QueryScratch);
+
+	for (const int32 Index : QueryScratch)
+	{
+		if (UTargetSystemDependencies* Dependencies = Targetables[Index].Get())
+		{
+			OutTargetables.Add(Dependencies);
+		}
+	}
+}
+
+TSharedRef<const FTargetSystemTargetSnapshot, ESPMode::ThreadSafe> UTargetSystemSubsystem::GetTargetSnapshot()
+{
+	check(IsInGameThread());
+
+	// Only captured for frames something asks for one
+	if (PublishedTargetSnapshotFrame != GFrameCounter)
+	{
+		PublishTargetSnapshot();
+	}
+	return TargetSnapshots[PublishedTargetSnapshot].ToSharedRef();
+}
+
+void UTargetSystemSubsystem::PublishTargetSnapshot()
+{
+	TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_PublishTargetSnapshot);
+
+	// A task still reading the back buffer keeps it, the capture goes into a new one instead
+	const int32 BackIndex = 1 - PublishedTargetSnapshot;
+	TSharedPtr<FTargetSystemTargetSnapshot, ESPMode::ThreadSafe>& BackSnapshot = TargetSnapshots[BackIndex];
+	if (!BackSnapshot.IsUnique())
+	{
+		INC_DWORD_STAT(STAT_TargetSystemTargetSnapshotAllocations);
+		BackSnapshot = MakeShared<FTargetSystemTargetSnapshot, ESPMode::ThreadSafe>();
+	}
+
+	BackSnapshot->Capture(GFrameCounter, Targetables);
+	PublishedTargetSnapshot = BackIndex;
+	PublishedTargetSnapshotFrame = GFrameCounter;
+}
+
+void UTargetSystemSubsystem::SetGridCellSize(const float CellSize)
+{
+	Grid.SetCellSize(CellSize);
+}
+
+bool UTargetSystemSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTargetSystemSubsystem::RemoveTargetableAt(const int32 Index)
+{
+	TargetableIndices.Remove(Targetables[Index]);
+	Targetables.RemoveAtSwap(Index);
+	Grid.RemoveAtSwap(Index);
+
+	// The last targetable took the removed slot
+	if (Targetables.IsValidIndex(Index))
+	{
+		TargetableIndices.Add(Targetables[Index], Index);
+	}
+}
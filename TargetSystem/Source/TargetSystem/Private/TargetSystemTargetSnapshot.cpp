@@ -0,0 +1,46 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TargetSystemTargetSnapshot.h"
+
+#include "BTargetPoint.h"
+#include "TargetSystemDependencies.h"
+#include "GameFramework/Actor.h"
+
+void FTargetSystemTargetSnapshot::Capture(const uint64 InFrame, const TArray<TWeakObjectPtr<UTargetSystemDependencies>>& Targetables)
+{
+	Frame = InFrame;
+	Targets.Reset(Targetables.Num());
+	TargetPointLocations.Reset();
+	TargetIndices.Reset();
+
+	for (const TWeakObjectPtr<UTargetSystemDependencies>& WeakDependencies : Targetables)
+	{
+		const UTargetSystemDependencies* Dependencies = WeakDependencies.Get();
+		const AActor* Owner = Dependencies ? Dependencies->GetOwner() : nullptr;
+		if (!IsValid(Owner)) continue;
+
+		const FTargetActorDetails& Details = Dependencies->GetTargetActorDetails();
+
+		FTargetSystemTargetState& Target = Targets.AddDefaulted_GetRef();
+		Target.Dependencies = Dependencies;
+		Target.Location = Owner->GetActorLocation();
+		Target.FirstTargetPoint = TargetPointLocations.Num();
+		Target.bCouldBeTarget = Details.bCouldBeTarget;
+		Target.bIsTargetable = Details.bIsTargetable;
+
+		for (const UBTargetPoint* TargetPoint : Details.TargetPoints)
+		{
+			TargetPointLocations.Add(IsValid(TargetPoint) ? TargetPoint->GetComponentLocation() : Target.Location);
+		}
+		Target.NumTargetPoints = TargetPointLocations.Num() - Target.FirstTargetPoint;
+
+		TargetIndices.Add(Dependencies, Targets.Num() - 1);
+	}
+}
+
+int32 FTargetSystemTargetSnapshot::FindTarget(const UTargetSystemDependencies* Dependencies) const
+{
+	const int32* Index = TargetIndices.Find(Dependencies);
+	return Index ? *Index : INDEX_NONE;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TargetSystemViewSnapshot.h"
+
+#include "SceneView.h"
+#include "TargetSystemCore.h"
+#include "Camera/CameraComponent.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+FTargetSystemViewSnapshot FTargetSystemViewSnapshot::Capture(const AActor* ViewOwner, const APlayerController* PlayerController)
+{
+	FTargetSystemViewSnapshot Snapshot;
+	if (!IsValid(ViewOwner)) return Snapshot;
+
+	Snapshot.bIsCaptured = true;
+
+	const UCameraComponent* CameraComponent = ViewOwner->FindComponentByClass<UCameraComponent>();
+	if (IsValid(CameraComponent))
+	{
+		Snapshot.ViewLocation = CameraComponent->GetComponentLocation();
+		Snapshot.ViewRotation = CameraComponent->GetComponentRotation();
+	}
+	else
+	{
+		Snapshot.ViewLocation = ViewOwner->GetActorLocation();
+		Snapshot.ViewRotation = ViewOwner->GetActorRotation();
+	}
+
+	if (!IsValid(PlayerController)) return Snapshot;
+
+	Snapshot.bHasPlayerController = true;
+
+	const ULocalPlayer* LocalPlayer = PlayerController->GetLocalPlayer();
+	if (LocalPlayer && LocalPlayer->ViewportClient)
+	{
+		FSceneViewProjectionData ProjectionData;
+		if (LocalPlayer->GetProjectionData(LocalPlayer->ViewportClient->Viewport, ProjectionData))
+		{
+			Snapshot.ViewProjectionMatrix = ProjectionData.ComputeViewProjectionMatrix();
+			Snapshot.ViewRect = ProjectionData.GetConstrainedViewRect();
+			Snapshot.bHasProjection = true;
+		}
+	}
+
+	if (const UGameViewportClient* GameViewport = PlayerController->GetWorld()->GetGameViewport())
+	{
+		GameViewport->GetViewportSize(Snapshot.ViewportSize);
+	}
+
+	return Snapshot;
+}
+
+bool FTargetSystemViewSnapshot::ProjectWorldToScreen(const FVector& WorldLocation, FVector2D& OutScreenLocation) const
+{
+	if (bHasProjection && FSceneView::ProjectWorldToScreen(WorldLocation, ViewRect, ViewProjectionMatrix, OutScreenLocation))
+	{
+		return true;
+	}
+
+	OutScreenLocation = FVector2D::ZeroVector;
+	return false;
+}
+
+float FTargetSystemViewSnapshot::GetYawAngle(const FVector& Location) const
+{
+	const FVector ToLocation = Location - ViewLocation;
+	return TargetSystemCore::GetYawAngle(ViewRotation.Yaw, ToLocation.X, ToLocation.Y);
+}
+
+bool FTargetSystemViewSnapshot::IsInViewport(const FVector& Location) const
+{
+	if (!bHasPlayerController) return true;
+
+	FVector2D ScreenLocation;
+	ProjectWorldToScreen(Location, ScreenLocation);
+
+	return ScreenLocation.X > 10.f && ScreenLocation.Y > 10.f && ScreenLocation.X < ViewportSize.X && ScreenLocation.Y < ViewportSize.Y;
+}
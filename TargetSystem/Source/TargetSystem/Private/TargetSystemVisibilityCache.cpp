@@ -0,0 +1,68 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TargetSystemVisibilityCache.h"
+
+bool FTargetSystemVisibilityCache::Find(
+	const UObject* Target,
+	const FVector& SourceLocation,
+	const FVector& TargetLocation,
+	const double Now,
+	const double MaxAge,
+	const float InvalidationDistance,
+	bool& bOutVisible)
+{
+	const FEntry* Entry = Entries.Find(Target);
+	const double InvalidationDistanceSquared = FMath::Square(static_cast<double>(InvalidationDistance));
+
+	if (!Entry
+		|| Now - Entry->Timestamp >= MaxAge
+		|| FVector::DistSquared(Entry->SourceLocation, SourceLocation) > InvalidationDistanceSquared
+		|| FVector::DistSquared(Entry->TargetLocation, TargetLocation) > InvalidationDistanceSquared)
+	{
+		++Misses;
+		return false;
+	}
+
+	++Hits;
+	bOutVisible = Entry->bVisible;
+	return true;
+}
+
+void FTargetSystemVisibilityCache::Store(
+	const UObject* Target, const FVector& SourceLocation, const FVector& TargetLocation, const double Now, const bool bVisible)
+{
+	if (!Target) return;
+
+	FEntry& Entry = Entries.FindOrAdd(Target);
+	Entry.SourceLocation = SourceLocation;
+	Entry.TargetLocation = TargetLocation;
+	Entry.Timestamp = Now;
+	Entry.bVisible = bVisible;
+}
+
+void FTargetSystemVisibilityCache::Remove(const UObject* Target)
+{
+	Entries.Remove(Target);
+}
+
+void FTargetSystemVisibilityCache::RemoveExpired(const double Now, const double MaxAge)
+{
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (Now - It.Value().Timestamp < MaxAge && It.Key().ResolveObjectPtr()) continue;
+
+		It.RemoveCurrent();
+	}
+}
+
+void FTargetSystemVisibilityCache::Reset()
+{
+	Entries.Reset();
+}
+
+void FTargetSystemVisibilityCache::ResetCounters()
+{
+	Hits = 0;
+	Misses = 0;
+}
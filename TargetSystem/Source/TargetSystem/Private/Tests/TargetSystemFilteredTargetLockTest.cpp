@@ -0,0 +1,105 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TFT_SwitchTargetLock.h"
+#include "TSLT_TargetSystemRegistry.h"
+#include "TST_FilteredTargetLock.h"
+#include "TST_TargetLock.h"
+#include "TargetSystemTestWorld.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/AutomationTest.h"
+#include "TargetingSystem/TargetingPreset.h"
+#include "TargetingSystem/TargetingSubsystem.h"
+#include "Types/TargetingSystemTypes.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace TargetSystemFilteredTargetLockTest
+{
+	UTargetingPreset* MakePreset(const TArray<TSubclassOf<UTargetingTask>>& TaskClasses)
+	{
+		UTargetingPreset* Preset = NewObject<UTargetingPreset>();
+		TArray<TObjectPtr<UTargetingTask>>& Tasks = const_cast<FTargetingTaskSet*>(Preset->GetTargetingTaskSet())->Tasks;
+
+		UTSLT_TargetSystemRegistry* RegistryTask = NewObject<UTSLT_TargetSystemRegistry>(Preset);
+		RegistryTask->Radius = 5000.f;
+		Tasks.Add(RegistryTask);
+
+		for (const TSubclassOf<UTargetingTask>& TaskClass : TaskClasses)
+		{
+			Tasks.Add(NewObject<UTargetingTask>(Preset, TaskClass));
+		}
+		return Preset;
+	}
+
+	TArray<AActor*> Execute(UTargetingPreset* Preset, AActor* Source, const ETargetSwitchMode Mode, AActor* CurrentTarget)
+	{
+		// Every request gets its own context, like UNextTargetSystemComponent hands out a reset one
+		UTargetLockContext* TargetLockContext = NewObject<UTargetLockContext>();
+		TargetLockContext->Mode = Mode;
+		TargetLockContext->CurrentTarget = CurrentTarget;
+
+		FTargetingSourceContext SourceContext;
+		SourceContext.SourceActor = Source;
+		SourceContext.SourceObject = TargetLockContext;
+
+		UTargetingSubsystem* TargetingSubsystem = UTargetingSubsystem::Get(Source->GetWorld());
+		const FTargetingRequestHandle Handle = UTargetingSubsystem::MakeTargetRequestHandle(Preset, SourceContext);
+		TargetingSubsystem->ExecuteTargetingRequestWithHandle(Handle);
+
+		TArray<AActor*> Results;
+		TargetingSubsystem->GetTargetingResultsActors(Handle, Results);
+		UTargetingSubsystem::ReleaseTargetRequestHandle(Handle);
+		return Results;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FTargetSystemFilteredTargetLockTest,
+	"TargetSystem.Targeting.FilteredTargetLockMatchesFilterAndSort",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FTargetSystemFilteredTargetLockTest::RunTest(const FString& Parameters)
+{
+	using namespace TargetSystemFilteredTargetLockTest;
+
+	const FTargetSystemTestWorld TestWorld;
+	if (!TestNotNull(TEXT("Targeting subsystem"), UTargetingSubsystem::Get(TestWorld.GetWorld()))) return false;
+
+	APawn* Player = Cast<APawn>(TestWorld.SpawnActor(FVector::ZeroVector, APawn::StaticClass()));
+
+	TArray<AActor*> Targets;
+	for (const FVector& Location : {
+		FVector(1000.f, 0.f, 0.f), FVector(1500.f, -800.f, 0.f), FVector(800.f, 900.f, 0.f),
+		FVector(2500.f, 200.f, 0.f), FVector(-1200.f, 300.f, 0.f)})
+	{
+		Targets.Add(TestWorld.SpawnTarget(Location));
+	}
+
+	UTargetingPreset* FusedPreset = MakePreset({UTST_FilteredTargetLock::StaticClass()});
+	UTargetingPreset* SeparatePreset = MakePreset({UTFT_SwitchTargetLock::StaticClass(), UTST_TargetLock::StaticClass()});
+
+	const auto TestPresetsMatch = [&](const TCHAR* What, const ETargetSwitchMode Mode, AActor* CurrentTarget)
+	{
+		const TArray<AActor*> Fused = Execute(FusedPreset, Player, Mode, CurrentTarget);
+		const TArray<AActor*> Separate = Execute(SeparatePreset, Player, Mode, CurrentTarget);
+		TestTrue(FString::Printf(TEXT("%s: same targets in the same order"), What), Fused == Separate);
+		return Fused.Num();
+	};
+
+	// Both presets filter every target out while the pawn has no controller
+	TestEqual(TEXT("Targets without a controller"), TestPresetsMatch(TEXT("Without a controller"), ETargetSwitchMode::LockOn, nullptr), 0);
+
+	APlayerController* PC = Cast<APlayerController>(TestWorld.SpawnActor(FVector::ZeroVector, APlayerController::StaticClass()));
+	PC->Possess(Player);
+	if (!TestTrue(TEXT("Pawn is possessed"), Player->GetController() == PC)) return false;
+
+	TestEqual(TEXT("Lock on targets"), TestPresetsMatch(TEXT("Lock on"), ETargetSwitchMode::LockOn, nullptr), Targets.Num());
+	TestPresetsMatch(TEXT("Switch left"), ETargetSwitchMode::SwitchLeft, Targets[0]);
+	TestPresetsMatch(TEXT("Switch right"), ETargetSwitchMode::SwitchRight, Targets[0]);
+
+	return true;
+}
+
+#endif
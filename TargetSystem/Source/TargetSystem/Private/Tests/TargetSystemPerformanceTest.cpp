@@ -0,0 +1,266 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TargetSystemComponent.h"
+#include "TargetSystemTestPawn.h"
+#include "TargetSystemTestWorld.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/UObjectArray.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace TargetSystemPerformanceTest
+{
+	enum class ELayout : uint8
+	{
+		// Disc in front of the player, every target competes for the lock
+		Cluster,
+		// Circle around the player, only the targets in front are within MaximumFindAngle
+		Ring,
+		// Scattered in front of the player behind cube occluders, so line of sight traces hit and miss
+		RandomOccluders,
+	};
+
+	const TCHAR* const LayoutNames[] = {TEXT("Cluster"), TEXT("Ring"), TEXT("RandomOccluders")};
+	const int32 TargetCounts[] = {10, 100, 1000};
+
+	constexpr int32 NumIterations = 1000;
+
+	// Longer than the switch cooldown, so every iteration may switch again
+	constexpr float CooldownFrameTime = 0.3f;
+
+	/** Latency and UObject creation of one operation, sampled once per iteration */
+	struct FOperationSamples
+	{
+		explicit FOperationSamples(const TCHAR* InName)
+			: Name(InName)
+		{
+			Cycles.Reserve(NumIterations);
+		}
+
+		template <typename FunctionType>
+		void Measure(FunctionType&& Function)
+		{
+			const int32 NumObjectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Function();
+			Cycles.Add(FPlatformTime::Cycles64() - StartCycles);
+			NumObjectsCreated += GUObjectArray.GetObjectArrayNumMinusAvailable() - NumObjectsBefore;
+		}
+
+		FString Summarize() const
+		{
+			if (Cycles.IsEmpty()) return FString::Printf(TEXT("%s: no samples"), Name);
+
+			TArray<uint64> Sorted = Cycles;
+			Sorted.Sort();
+
+			uint64 TotalCycles = 0;
+			for (const uint64 Sample : Sorted)
+			{
+				TotalCycles += Sample;
+			}
+
+			const auto ToMicroseconds = [](const uint64 SampleCycles)
+			{
+				return FPlatformTime::ToMilliseconds64(SampleCycles) * 1000.0;
+			};
+			const auto Percentile = [&Sorted, &ToMicroseconds](const double Fraction)
+			{
+				return ToMicroseconds(Sorted[FMath::Min(FMath::FloorToInt(Fraction * Sorted.Num()), Sorted.Num() - 1)]);
+			};
+
+			return FString::Printf(
+				TEXT("%s: mean %.2f us, p50 %.2f us, p95 %.2f us, p99 %.2f us over %d calls, %.3f UObjects created per call, %d without result"),
+				Name, ToMicroseconds(TotalCycles) / Sorted.Num(), Percentile(0.5), Percentile(0.95), Percentile(0.99),
+				Sorted.Num(), static_cast<double>(NumObjectsCreated) / Sorted.Num(), NumMisses);
+		}
+
+		const TCHAR* Name;
+		TArray<uint64> Cycles;
+		int64 NumObjectsCreated = 0;
+		int32 NumMisses = 0;
+	};
+
+	FVector MakeTargetLocation(const ELayout Layout, const int32 Index, const int32 NumTargets, FRandomStream& Random)
+	{
+		switch (Layout)
+		{
+		case ELayout::Cluster:
+		{
+			const float Angle = Random.FRandRange(0.f, UE_TWO_PI);
+			const float Distance = 600.f * FMath::Sqrt(Random.FRand());
+			return FVector(1500.f + Distance * FMath::Cos(Angle), Distance * FMath::Sin(Angle), 0.f);
+		}
+		case ELayout::Ring:
+		{
+			const float Angle = UE_TWO_PI * Index / NumTargets;
+			return FVector(1500.f * FMath::Cos(Angle), 1500.f * FMath::Sin(Angle), 0.f);
+		}
+		default:
+			return FVector(Random.FRandRange(300.f, 2300.f), Random.FRandRange(-1500.f, 1500.f), 0.f);
+		}
+	}
+
+	void SpawnOccluders(const FTargetSystemTestWorld& TestWorld, const int32 NumOccluders, FRandomStream& Random)
+	{
+		UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+		for (int32 i = 0; i < NumOccluders; ++i)
+		{
+			const FVector Location(Random.FRandRange(200.f, 2000.f), Random.FRandRange(-1500.f, 1500.f), 0.f);
+			AStaticMeshActor* Occluder = Cast<AStaticMeshActor>(TestWorld.SpawnActor(Location, AStaticMeshActor::StaticClass()));
+
+			// Static mobility ignores a mesh set after registration
+			UStaticMeshComponent* Mesh = Occluder->GetStaticMeshComponent();
+			Mesh->SetMobility(EComponentMobility::Movable);
+			Mesh->SetStaticMesh(Cube);
+			Mesh->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+			Occluder->SetActorScale3D(FVector(0.5f, 2.f, 2.f));
+		}
+	}
+
+	UTargetSystemComponent* SpawnPlayer(const FTargetSystemTestWorld& TestWorld)
+	{
+		AActor* Player = TestWorld.SpawnActor(FVector::ZeroVector, APawn::StaticClass());
+		UTargetSystemComponent* Component = NewObject<UTargetSystemComponent>(Player);
+
+		// Protected setting, the AutoSwitchTarget samples are taken when the locked target is reported dead
+		if (const FBoolProperty* AutoTargetSwitch = FindFProperty<FBoolProperty>(UTargetSystemComponent::StaticClass(), TEXT("bAutoTargetSwitch")))
+		{
+			AutoTargetSwitch->SetPropertyValue_InContainer(Component, true);
+		}
+
+		Component->RegisterComponent();
+		return Component;
+	}
+
+	void EnsureLocked(UTargetSystemComponent* Component)
+	{
+		if (!Component->IsLocked())
+		{
+			Component->TryStartTargetLock();
+		}
+	}
+}
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(
+	FTargetSystemPerformanceTest,
+	"TargetSystem.Performance",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+void FTargetSystemPerformanceTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	using namespace TargetSystemPerformanceTest;
+
+	for (int32 Layout = 0; Layout < UE_ARRAY_COUNT(LayoutNames); ++Layout)
+	{
+		for (const int32 NumTargets : TargetCounts)
+		{
+			OutBeautifiedNames.Add(FString::Printf(TEXT("%s.%d"), LayoutNames[Layout], NumTargets));
+			OutTestCommands.Add(FString::Printf(TEXT("%d %d"), Layout, NumTargets));
+		}
+	}
+}
+
+bool FTargetSystemPerformanceTest::RunTest(const FString& Parameters)
+{
+	using namespace TargetSystemPerformanceTest;
+
+	FString LayoutParameter;
+	FString NumTargetsParameter;
+	if (!Parameters.Split(TEXT(" "), &LayoutParameter, &NumTargetsParameter))
+	{
+		AddError(FString::Printf(TEXT("Invalid parameters '%s'"), *Parameters));
+		return false;
+	}
+	const ELayout Layout = static_cast<ELayout>(FCString::Atoi(*LayoutParameter));
+	const int32 NumTargets = FCString::Atoi(*NumTargetsParameter);
+
+	const FTargetSystemTestWorld TestWorld;
+
+	FRandomStream Random(NumTargets);
+	for (int32 i = 0; i < NumTargets; ++i)
+	{
+		TestWorld.SpawnActor(MakeTargetLocation(Layout, i, NumTargets, Random), ATargetSystemTestPawn::StaticClass());
+	}
+	if (Layout == ELayout::RandomOccluders)
+	{
+		SpawnOccluders(TestWorld, FMath::Max(NumTargets / 10, 4), Random);
+	}
+
+	UTargetSystemComponent* Component = SpawnPlayer(TestWorld);
+	const uint64 UsedPhysicalBefore = FPlatformMemory::GetStats().UsedPhysical;
+
+	// Each lock starts unlocked, so every sample gathers and ranks the candidates again
+	FOperationSamples LockSamples(TEXT("TryStartTargetLock"));
+	for (int32 i = 0; i < NumIterations; ++i)
+	{
+		LockSamples.Measure([Component]() { Component->TryStartTargetLock(); });
+		if (!Component->IsLocked())
+		{
+			++LockSamples.NumMisses;
+		}
+		Component->StopObservingTarget(true);
+	}
+
+	// Alternates left and right, ticking past the cooldown in between
+	FOperationSamples SwitchSamples(TEXT("SwitchTarget"));
+	for (int32 i = 0; i < NumIterations; ++i)
+	{
+		EnsureLocked(Component);
+		const AActor* PreviousTarget = Component->GetLockedOnTargetActor();
+		const FVector2D AxisValue(i % 2 == 0 ? 1.f : -1.f, 0.f);
+
+		SwitchSamples.Measure([Component, AxisValue]() { Component->SwitchTarget(AxisValue); });
+		if (Component->GetLockedOnTargetActor() == PreviousTarget)
+		{
+			++SwitchSamples.NumMisses;
+		}
+		TestWorld.Tick(CooldownFrameTime, CooldownFrameTime);
+	}
+	Component->StopObservingTarget(true);
+
+	// The locked target is reported dead, which drops it from the candidates and auto switches to the next one
+	FOperationSamples AutoSwitchSamples(TEXT("AutoSwitchTarget"));
+	for (int32 i = 0; i < NumIterations; ++i)
+	{
+		EnsureLocked(Component);
+		const AActor* PreviousTarget = Component->GetLockedOnTargetActor();
+		if (!PreviousTarget)
+		{
+			++AutoSwitchSamples.NumMisses;
+			continue;
+		}
+
+		AutoSwitchSamples.Measure([Component]() { Component->StopObservingTarget(false, true); });
+		if (!Component->IsLocked() || Component->GetLockedOnTargetActor() == PreviousTarget)
+		{
+			++AutoSwitchSamples.NumMisses;
+		}
+		TestWorld.Tick(CooldownFrameTime, CooldownFrameTime);
+
+		// The next lock gathers the candidates again, the dead target included
+		Component->StopObservingTarget(true);
+	}
+	Component->StopObservingTarget(true);
+
+	const int64 UsedPhysicalDelta = static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical) - static_cast<int64>(UsedPhysicalBefore);
+
+	AddInfo(FString::Printf(TEXT("%s, %d targets"), LayoutNames[static_cast<int32>(Layout)], NumTargets));
+	AddInfo(LockSamples.Summarize());
+	AddInfo(SwitchSamples.Summarize());
+	AddInfo(AutoSwitchSamples.Summarize());
+	AddInfo(FString::Printf(TEXT("Used physical memory delta while sampling: %.1f KiB"), UsedPhysicalDelta / 1024.0));
+
+	TestTrue(TEXT("Locks were acquired"), LockSamples.NumMisses < NumIterations);
+	return true;
+}
+
+#endif
@@ -0,0 +1,54 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TSLT_TargetSystemRegistry.h"
+#include "TargetSystemTestWorld.h"
+#include "Misc/AutomationTest.h"
+#include "TargetingSystem/TargetingPreset.h"
+#include "TargetingSystem/TargetingSubsystem.h"
+#include "Types/TargetingSystemTypes.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FTargetSystemRegistryTaskTest,
+	"TargetSystem.Targeting.RegistrySelectionInPreset",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FTargetSystemRegistryTaskTest::RunTest(const FString& Parameters)
+{
+	const FTargetSystemTestWorld TestWorld;
+
+	AActor* Source = TestWorld.SpawnActor(FVector::ZeroVector);
+	AActor* NearTarget = TestWorld.SpawnTarget(FVector(1000.f, 0.f, 0.f));
+	AActor* OtherNearTarget = TestWorld.SpawnTarget(FVector(0.f, -2000.f, 0.f));
+	AActor* FarTarget = TestWorld.SpawnTarget(FVector(5000.f, 0.f, 0.f));
+
+	// Like a preset asset, the task is instanced in the preset and has no world of its own
+	UTargetingPreset* Preset = NewObject<UTargetingPreset>();
+	UTSLT_TargetSystemRegistry* RegistryTask = NewObject<UTSLT_TargetSystemRegistry>(Preset);
+	RegistryTask->Radius = 3000.f;
+	const_cast<FTargetingTaskSet*>(Preset->GetTargetingTaskSet())->Tasks.Add(RegistryTask);
+
+	UTargetingSubsystem* TargetingSubsystem = UTargetingSubsystem::Get(TestWorld.GetWorld());
+	if (!TestNotNull(TEXT("Targeting subsystem"), TargetingSubsystem)) return false;
+
+	FTargetingSourceContext SourceContext;
+	SourceContext.SourceActor = Source;
+	const FTargetingRequestHandle Handle = UTargetingSubsystem::MakeTargetRequestHandle(Preset, SourceContext);
+	TargetingSubsystem->ExecuteTargetingRequestWithHandle(Handle);
+
+	TArray<AActor*> Results;
+	TargetingSubsystem->GetTargetingResultsActors(Handle, Results);
+	UTargetingSubsystem::ReleaseTargetRequestHandle(Handle);
+
+	TestEqual(TEXT("Selected targets"), Results.Num(), 2);
+	TestTrue(TEXT("Target within the radius is selected"), Results.Contains(NearTarget));
+	TestTrue(TEXT("Second target within the radius is selected"), Results.Contains(OtherNearTarget));
+	TestFalse(TEXT("Target outside the radius is not selected"), Results.Contains(FarTarget));
+	TestFalse(TEXT("Source is not selected"), Results.Contains(Source));
+
+	return true;
+}
+
+#endif
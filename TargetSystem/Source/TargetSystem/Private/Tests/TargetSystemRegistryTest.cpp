@@ -0,0 +1,50 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TargetSystemDependencies.h"
+#include "TargetSystemSubsystem.h"
+#include "TargetSystemTestWorld.h"
+#include "GameFramework/Actor.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FTargetSystemRegistryTest,
+	"TargetSystem.Registry.RegistersOnBeginPlay",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FTargetSystemRegistryTest::RunTest(const FString& Parameters)
+{
+	const FTargetSystemTestWorld TestWorld;
+
+	UTargetSystemSubsystem* Registry = UTargetSystemSubsystem::Get(TestWorld.GetWorld());
+	if (!TestNotNull(TEXT("Registry"), Registry)) return false;
+
+	// Never calls SetIsTargetable, like targets set up in Blueprint
+	AActor* Target = TestWorld.SpawnTarget(FVector(500.f, 0.f, 0.f));
+	UTargetSystemDependencies* Dependencies = Target->FindComponentByClass<UTargetSystemDependencies>();
+	if (!TestNotNull(TEXT("Dependencies"), Dependencies)) return false;
+
+	const auto IsGathered = [Registry]()
+	{
+		TArray<UTargetSystemDependencies*> Targetables;
+		Registry->QueryTargetablesInRadius(FVector::ZeroVector, 1000.f, Targetables);
+		return Targetables.Num() == 1;
+	};
+
+	TestTrue(TEXT("Registered on BeginPlay"), IsGathered());
+
+	Dependencies->SetIsTargetable(false);
+	TestFalse(TEXT("SetIsTargetable(false) unregisters"), IsGathered());
+
+	Dependencies->SetIsTargetable(true);
+	TestTrue(TEXT("SetIsTargetable(true) registers again"), IsGathered());
+
+	Dependencies->NotifyDied();
+	TestFalse(TEXT("NotifyDied unregisters"), IsGathered());
+
+	return true;
+}
+
+#endif
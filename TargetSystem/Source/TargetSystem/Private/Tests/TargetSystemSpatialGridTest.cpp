@@ -0,0 +1,108 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TargetSystemSpatialGrid.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FTargetSystemSpatialGridTest,
+	"TargetSystem.SpatialGrid.MatchesBruteForce",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FTargetSystemSpatialGridTest::RunTest(const FString& Parameters)
+{
+	constexpr float CellSize = 500.f;
+	constexpr int32 NumSteps = 4000;
+
+	FRandomStream Random(1337);
+	FTargetSystemSpatialGrid Grid(CellSize);
+
+	// Mirrors the grid's dense indices, removals follow the same RemoveAtSwap fix-up
+	TArray<FVector> Locations;
+
+	// One location in four lies exactly on cell corners, so cell boundaries and exact radii are covered
+	const auto RandomLocation = [&Random]()
+	{
+		if (Random.RandRange(0, 3) == 0)
+		{
+			return FVector(Random.RandRange(-8, 8) * CellSize, Random.RandRange(-8, 8) * CellSize, 0.f);
+		}
+		return FVector(Random.FRandRange(-4000.f, 4000.f), Random.FRandRange(-4000.f, 4000.f), Random.FRandRange(-300.f, 300.f));
+	};
+	const auto RandomRadius = [&Random]()
+	{
+		switch (Random.RandRange(0, 3))
+		{
+		case 0: return Random.RandRange(0, 4) * CellSize;
+		case 1: return 100000.f;
+		default: return Random.FRandRange(0.f, 3000.f);
+		}
+	};
+
+	TArray<int32> GridIndices;
+	TArray<int32> ScanIndices;
+	for (int32 Step = 0; Step < NumSteps; ++Step)
+	{
+		const int32 Operation = Random.RandRange(0, 9);
+		if (Locations.IsEmpty() || Operation < 4)
+		{
+			const FVector Location = RandomLocation();
+			Grid.Add(Location);
+			Locations.Add(Location);
+		}
+		else if (Operation < 7)
+		{
+			const int32 Index = Random.RandRange(0, Locations.Num() - 1);
+			const FVector Location = RandomLocation();
+			Grid.Update(Index, Location);
+			Locations[Index] = Location;
+		}
+		else
+		{
+			const int32 Index = Random.RandRange(0, Locations.Num() - 1);
+			Grid.RemoveAtSwap(Index);
+			Locations.RemoveAtSwap(Index);
+		}
+
+		if (!TestEqual(TEXT("Entry count"), Grid.Num(), Locations.Num())) return false;
+		for (int32 i = 0; i < Locations.Num(); ++i)
+		{
+			if (Grid.GetLocation(i) != Locations[i])
+			{
+				AddError(FString::Printf(TEXT("Step %d: entry %d moved to another index"), Step, i));
+				return false;
+			}
+		}
+
+		const FVector Center = RandomLocation();
+		const float Radius = RandomRadius();
+		const double RadiusSquared = FMath::Square(static_cast<double>(Radius));
+
+		GridIndices.Reset();
+		Grid.QueryRadius(Center, Radius, GridIndices);
+
+		ScanIndices.Reset();
+		for (int32 i = 0; i < Locations.Num(); ++i)
+		{
+			if (FVector::DistSquared(Locations[i], Center) <= RadiusSquared)
+			{
+				ScanIndices.Add(i);
+			}
+		}
+
+		GridIndices.Sort();
+		if (GridIndices != ScanIndices)
+		{
+			AddError(FString::Printf(TEXT("Step %d: query at %s, radius %.1f returned %d entries, brute force found %d"),
+				Step, *Center.ToString(), Radius, GridIndices.Num(), ScanIndices.Num()));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+#endif
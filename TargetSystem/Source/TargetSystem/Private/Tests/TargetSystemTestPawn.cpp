@@ -0,0 +1,37 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TargetSystemTestPawn.h"
+
+#include "BTargetPoint.h"
+#include "TargetSystemDependencies.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/CollisionProfile.h"
+
+ATargetSystemTestPawn::ATargetSystemTestPawn()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	Capsule = CreateDefaultSubobject<UCapsuleComponent>(TEXT("Capsule"));
+	Capsule->InitCapsuleSize(34.f, 88.f);
+	Capsule->SetCollisionProfileName(UCollisionProfile::Pawn_ProfileName);
+	RootComponent = Capsule;
+
+	TargetPoint = CreateDefaultSubobject<UBTargetPoint>(TEXT("TargetPoint"));
+	TargetPoint->SetupAttachment(Capsule);
+
+	Dependencies = CreateDefaultSubobject<UTargetSystemDependencies>(TEXT("Dependencies"));
+}
+
+bool ATargetSystemTestPawn::IsTargetable() const
+{
+	return Dependencies && Dependencies->GetTargetActorDetails().bIsTargetable;
+}
+
+void ATargetSystemTestPawn::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Dependencies->SetUp({TargetPoint});
+	Dependencies->SetIsTargetable(true);
+}
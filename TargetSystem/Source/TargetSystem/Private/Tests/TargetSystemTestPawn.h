@@ -0,0 +1,36 @@
+// Copyright (c) 2024 NextGenium
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Pawn.h"
+#include "TargetSystemInterface.h"
+#include "TargetSystemTestPawn.generated.h"
+
+class UBTargetPoint;
+class UCapsuleComponent;
+
+/** Targetable pawn spawned by the automation tests, with a pawn capsule for the line of sight traces and one target point */
+UCLASS(NotBlueprintable, NotPlaceable, Transient, HideDropdown)
+class ATargetSystemTestPawn : public APawn, public ITargetSystemInterface
+{
+	GENERATED_BODY()
+
+public:
+	ATargetSystemTestPawn();
+
+	virtual UTargetSystemDependencies* GetTargetSystemDependencies() override { return Dependencies; }
+	virtual bool IsTargetable() const override;
+
+protected:
+	virtual void BeginPlay() override;
+
+	UPROPERTY()
+	UCapsuleComponent* Capsule = nullptr;
+
+	UPROPERTY()
+	UTargetSystemDependencies* Dependencies = nullptr;
+
+	UPROPERTY()
+	UBTargetPoint* TargetPoint = nullptr;
+};
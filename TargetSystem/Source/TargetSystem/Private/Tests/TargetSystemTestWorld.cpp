@@ -0,0 +1,75 @@
+// Copyright (c) 2024 NextGenium
+
+
+#include "TargetSystemTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "TargetSystemDependencies.h"
+#include "Components/SceneComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/WorldSettings.h"
+
+FTargetSystemTestWorld::FTargetSystemTestWorld()
+{
+	World = UWorld::CreateWorld(EWorldType::Game, false);
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	// Without a game instance there is no game mode to start play, the world settings dispatch it the same way
+	if (!World->HasBegunPlay())
+	{
+		World->GetWorldSettings()->NotifyBeginPlay();
+	}
+}
+
+FTargetSystemTestWorld::~FTargetSystemTestWorld()
+{
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+}
+
+AActor* FTargetSystemTestWorld::SpawnActor(const FVector& Location, UClass* Class) const
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AActor* Actor = World->SpawnActor<AActor>(Class ? Class : AActor::StaticClass(), FTransform(Location), SpawnParameters);
+	if (Actor && !Actor->GetRootComponent())
+	{
+		USceneComponent* Root = NewObject<USceneComponent>(Actor, TEXT("Root"));
+		Actor->SetRootComponent(Root);
+		Root->RegisterComponent();
+		Actor->SetActorLocation(Location);
+	}
+	return Actor;
+}
+
+AActor* FTargetSystemTestWorld::SpawnTarget(const FVector& Location) const
+{
+	AActor* Target = SpawnActor(Location);
+
+	// Registered after the actor began play, so it begins play right away and joins the registry
+	UTargetSystemDependencies* Dependencies = NewObject<UTargetSystemDependencies>(Target);
+	Dependencies->RegisterComponent();
+	return Target;
+}
+
+void FTargetSystemTestWorld::Tick(float DeltaSeconds, const float MaxFrameTime) const
+{
+	while (DeltaSeconds > 0.f)
+	{
+		const float FrameTime = FMath::Min(DeltaSeconds, MaxFrameTime);
+		World->Tick(LEVELTICK_All, FrameTime);
+		++GFrameCounter;
+		DeltaSeconds -= FrameTime;
+	}
+}
+
+#endif
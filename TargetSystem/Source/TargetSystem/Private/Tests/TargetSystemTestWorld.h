@@ -0,0 +1,33 @@
+// Copyright (c) 2024 NextGenium
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+class AActor;
+class UWorld;
+
+/** Game world for automation tests, begins play when constructed and is destroyed with the fixture */
+struct FTargetSystemTestWorld
+{
+	FTargetSystemTestWorld();
+	~FTargetSystemTestWorld();
+
+	UWorld* GetWorld() const { return World; }
+
+	/** Spawns an actor of Class at Location, actors without a root component get a scene component as root */
+	AActor* SpawnActor(const FVector& Location, UClass* Class = nullptr) const;
+
+	/** Spawns an actor with a UTargetSystemDependencies component and nothing else, as a Blueprint target would be set up */
+	AActor* SpawnTarget(const FVector& Location) const;
+
+	/** Advances the world by DeltaSeconds, in frames of at most MaxFrameTime */
+	void Tick(float DeltaSeconds, float MaxFrameTime = 1.f / 60.f) const;
+
+private:
+	UWorld* World = nullptr;
+};
+
+#endif
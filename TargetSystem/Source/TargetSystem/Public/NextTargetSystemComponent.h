@@ -4,10 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "TargetSystemComponent.h"
+#include "Types/TargetingSystemTypes.h"
 #include "NextTargetSystemComponent.generated.h"
 
-struct FTargetingRequestHandle;
 class UTargetingPreset;
+class UTargetLockContext;
+enum class ETargetSwitchMode : uint8;
 /**
  * 
  */
@@ -33,10 +35,58 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Target Subsystem",
 		meta=(EditCondition="bUseTargetSubsystem"))
 	UTargetingPreset* TargetingPreset = nullptr;
+
+	// Delay between the background requests that keep the left and right switch targets up to date, one side per request
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Target Subsystem",
+		meta=(EditCondition="bUseTargetSubsystem", ClampMin = "0.0"))
+	float SwitchSlotRefreshInterval = 0.1f;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void UpdateSwitchSlots() override;
+	virtual void ResetSwitchSlots() override;
+	virtual TargetInterface FindPrecomputedSwitchTarget(const FVector2D& AxisValue) override;
 	
 private:
-	void ClearTargetingHandles();
+	FTargetingRequestHandle MakeTargetingRequest(ETargetSwitchMode Mode, AActor* CurrentTarget);
+	bool FinishTargetingRequest(const FTargetingRequestHandle& Handle);
+	void CancelTargetingRequest(FTargetingRequestHandle Handle);
+	void CancelTargetingRequests();
+	void DeferTargetingHandleRelease(const FTargetingRequestHandle& Handle);
+	void ReleaseDeferredTargetingHandles(bool bIncludeThisFrame);
+	void OnSwitchSlotRequestCompleted(FTargetingRequestHandle Handle, ETargetSwitchMode Mode);
+	FTargetSystemViewSnapshot CaptureRequestViewSnapshot() const;
+
+	UTargetLockContext* AcquireLockContext(ETargetSwitchMode Mode, AActor* CurrentTarget);
+	void ReleaseLockContext(const FTargetingRequestHandle& Handle);
 	
+	// Requests in flight, cancelled when superseded
 	UPROPERTY()
 	TArray<FTargetingRequestHandle> TargetingHandles;
+
+	// Completed or cancelled requests, the subsystem may still touch their handles during its current tick so they are
+	// released by the first request of a later frame
+	struct FDeferredHandleRelease
+	{
+		FTargetingRequestHandle Handle;
+		uint64 Frame = 0;
+	};
+	TArray<FDeferredHandleRelease> DeferredHandleReleases;
+
+	FTargetingRequestHandle LockRequestHandle;
+	uint64 LockRequestFrame = 0;
+
+	// Contexts of the targeting requests, reused once their request completed so steady-state locking allocates none
+	UPROPERTY()
+	TArray<UTargetLockContext*> LockContextPool;
+	TArray<UTargetLockContext*, TInlineAllocator<4>> FreeLockContexts;
+
+	// Background switch request in flight, its result is dropped if the slots were reset meanwhile
+	UPROPERTY()
+	FTargetingRequestHandle SwitchSlotRequestHandle;
+
+	// Last results of the background switch requests, indexed by bRight
+	TWeakObjectPtr<AActor> PrecomputedSwitchTargets[2];
+	bool bNextSwitchSlotRight = false;
+	double NextSwitchSlotRequestTime = 0.0;
 };
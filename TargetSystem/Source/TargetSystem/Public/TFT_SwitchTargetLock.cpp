@@ -3,13 +3,15 @@
 
 #include "TFT_SwitchTargetLock.h"
 
+#include "TargetSystemStats.h"
 #include "TST_TargetLock.h"
-#include "Blueprint/WidgetLayoutLibrary.h"
 
 bool UTFT_SwitchTargetLock::ShouldFilterTarget(
 	const FTargetingRequestHandle& TargetingHandle,
 	const FTargetingDefaultResultData& TargetData) const
 {
+	TARGETSYSTEM_SCOPE_CYCLE_COUNTER(STAT_TargetSystem_SwitchFilterTask);
+
 	const FTargetingSourceContext* SourceContext = FTargetingSourceContext::Find(TargetingHandle);
 	if (!SourceContext)
 	{
@@ -28,7 +30,7 @@ bool UTFT_SwitchTargetLock::ShouldFilterTarget(
 		return true;
 	}
 	
-	APlayerController* PC = Cast<APlayerController>(PlayerPawn->GetController());
+	const APlayerController* PC = Cast<APlayerController>(PlayerPawn->GetController());
 	if (!PC)
 	{
 		return true;
@@ -50,13 +52,10 @@ bool UTFT_SwitchTargetLock::ShouldFilterTarget(
 		return false;
 	}
 	
-	const FVector2D ViewportSize = UWidgetLayoutLibrary::GetViewportSize(PC);
-	const float InputDirection = TargetLockContext->Mode == ETargetSwitchMode::SwitchLeft ? -1.f : + 1.f;
-
-	FVector2D ScreenPos;
-	PC->ProjectWorldLocationToScreen(TargetActor->GetActorLocation(), ScreenPos);
-
-	const float DeltaX = ScreenPos.X - (ViewportSize.X * 0.5f);
+	// Projected once per request, UTST_TargetLock reads the same data
+	const FTargetSystemViewSnapshot& View = TargetLockContext->GetViewSnapshot(PlayerPawn, PC);
+	const FTargetLockTargetData& Data = TargetLockContext->GetTargetData(TargetActor, PlayerPawn, PC);
 
-	return DeltaX * InputDirection < 0;	
+	return TargetSystemCore::IsOppositeToSwitch(
+		Data.ScreenPosition.X, View.GetViewportCenter().X, TargetLockContext->Mode == ETargetSwitchMode::SwitchLeft);
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+// Copyright (c) 2024 NextGenium
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/TargetingSelectionTask.h"
+#include "TSLT_TargetSystemRegistry.generated.h"
+
+class AActor;
+struct FGenericTeamId;
+struct FTargetingSourceContext;
+
+/**
+ * Selects the targetables registered in UTargetSystemSubsystem around the source, filtered by radius, cone and team.
+ * Answered from the registry grid, so presets using it run no collision query for selection.
+ */
+UCLASS(DisplayName = "Target System Registry Selection")
+class TARGETSYSTEM_API UTSLT_TargetSystemRegistry : public UTargetingSelectionTask
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Execute(const FTargetingRequestHandle& TargetingHandle) const override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Selection", meta = (ClampMin = "0.0"))
+	float Radius = 3000.f;
+
+	/** Only keep targets within ConeHalfAngle of the source aim direction */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Selection", meta = (InlineEditConditionToggle))
+	bool bUseCone = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Selection", meta = (EditCondition = "bUseCone", ClampMin = "0.0", ClampMax = "180.0"))
+	float ConeHalfAngle = 60.f;
+
+	/** Filter by the attitude of the source team towards the target team, actors without a team are neutral */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Selection|Team")
+	bool bFilterByTeam = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Selection|Team", meta = (EditCondition = "bFilterByTeam"))
+	bool bIncludeHostile = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Selection|Team", meta = (EditCondition = "bFilterByTeam"))
+	bool bIncludeNeutral = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Selection|Team", meta = (EditCondition = "bFilterByTeam"))
+	bool bIncludeFriendly = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Selection")
+	bool bIgnoreSourceActor = true;
+
+private:
+	static FVector GetSourceLocation(const FTargetingSourceContext& SourceContext);
+	static FVector GetSourceDirection(const FTargetingSourceContext& SourceContext);
+	static FGenericTeamId GetTeamId(const AActor* Actor);
+
+	bool IsTeamSelected(const FGenericTeamId& SourceTeam, const AActor* Target) const;
+};
@@ -0,0 +1,30 @@
+// Copyright (c) 2024 NextGenium
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TST_TargetLock.h"
+#include "TST_FilteredTargetLock.generated.h"
+
+/**
+ * UTFT_SwitchTargetLock and UTST_TargetLock in a single task: each target is projected once into the request context's
+ * per-target data, which the filter and the scores both read. Scores are then normalized and sorted by
+ * USimpleTargetingSortTask as configured on the asset.
+ */
+UCLASS(DisplayName = "Target Lock Filter And Sort Task")
+class TARGETSYSTEM_API UTST_FilteredTargetLock : public UTST_TargetLock
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Execute(const FTargetingRequestHandle& TargetingHandle) const override;
+
+protected:
+	virtual float GetScoreForTarget(
+		const FTargetingRequestHandle& TargetingHandle,
+		const FTargetingDefaultResultData& TargetData
+	) const override;
+
+private:
+	void FilterTargets(const FTargetingRequestHandle& TargetingHandle) const;
+};
@@ -3,9 +3,46 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "TargetSystemCore.h"
+#include "TargetSystemViewSnapshot.h"
 #include "Tasks/SimpleTargetingSortTask.h"
 #include "TST_TargetLock.generated.h"
 
+class APawn;
+class APlayerController;
+class UTST_TargetLock;
+struct FTargetingDefaultResultData;
+
+/** Scores of every target of a request, computed in one pass by UTST_TargetLock */
+struct FTargetLockScoreBatch
+{
+	const UTST_TargetLock* Scorer = nullptr;
+	const FTargetingDefaultResultData* Results = nullptr;
+	int32 NumResults = 0;
+
+	TArray<float> Scores;
+
+	// Structure of arrays of target locations relative to the view origin, padded to a multiple of 4
+	TArray<float> X;
+	TArray<float> Y;
+	TArray<float> Z;
+
+	bool IsBuiltFor(const UTST_TargetLock* InScorer, const FTargetingDefaultResultData* InResults, const int32 InNumResults) const
+	{
+		return Scorer == InScorer && Results == InResults && NumResults == InNumResults;
+	}
+};
+
+/** Values of one target shared by the filter and sort tasks of a request, so each target is projected once */
+struct FTargetLockTargetData
+{
+	FVector2D ScreenPosition = FVector2D::ZeroVector;
+	float Distance = 0.f;
+
+	static FTargetLockTargetData Make(const AActor* Target, const APawn* Pawn, const FTargetSystemViewSnapshot& View);
+	static FTargetLockTargetData Make(const FVector& TargetLocation, const FVector& PawnLocation, const FTargetSystemViewSnapshot& View);
+};
+
 UENUM(BlueprintType)
 enum class ETargetSwitchMode : uint8
 {
@@ -25,6 +62,34 @@ public:
 
 	UPROPERTY(BlueprintReadWrite)
 	AActor* CurrentTarget = nullptr;
+
+	/** Pawn and controller of the request, resolved once by the first task so the others only read them back */
+	void SetRequester(const APawn* Pawn, const APlayerController* PC) const { RequesterPawn = Pawn; RequesterController = PC; }
+	bool HasRequester() const { return RequesterPawn && RequesterController; }
+
+	/** View shared by the filter and sort tasks of a request, captured on first use if the requester did not set it */
+	const FTargetSystemViewSnapshot& GetViewSnapshot(const APawn* Pawn, const APlayerController* PC) const;
+	void SetViewSnapshot(const FTargetSystemViewSnapshot& InViewSnapshot) { ViewSnapshot = InViewSnapshot; }
+	const FTargetSystemViewSnapshot& GetViewSnapshot() const { return GetViewSnapshot(RequesterPawn, RequesterController); }
+
+	FTargetLockScoreBatch& GetScoreBatch() const { return ScoreBatch; }
+
+	/** Screen position and distance of Target for this request, computed on first use */
+	const FTargetLockTargetData& GetTargetData(const AActor* Target, const APawn* Pawn, const APlayerController* PC) const;
+	const FTargetLockTargetData& GetTargetData(const AActor* Target) const { return GetTargetData(Target, RequesterPawn, RequesterController); }
+
+	/** Computes the data of every target with ParallelFor when there are enough of them, GetTargetData then only looks it up */
+	void PrecomputeTargetData(const TArray<FTargetingDefaultResultData>& TargetResults, const APawn* Pawn, const APlayerController* PC) const;
+
+	/** Clears the state of the last request so the context can be reused for another one, allocations are kept */
+	void Reset();
+
+private:
+	mutable const APawn* RequesterPawn = nullptr;
+	mutable const APlayerController* RequesterController = nullptr;
+	mutable FTargetSystemViewSnapshot ViewSnapshot;
+	mutable FTargetLockScoreBatch ScoreBatch;
+	mutable TMap<const AActor*, FTargetLockTargetData> TargetData;
 };
 
 
@@ -49,6 +114,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Targeting")
 	float ScreenOffsetScale = 1200.0f;
 
+	/** Score every target of the request in one vectorized pass instead of one projection per target */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Targeting")
+	bool bUseBatchScoring = true;
+
 protected:
 	virtual float GetScoreForTarget(
 		const FTargetingRequestHandle& TargetingHandle,
@@ -56,10 +125,16 @@ protected:
 	) const override;
 
 private:
-	float ComputeLockOnScore(const AActor* Target, const APawn* Pawn, APlayerController* PC) const;
-	float ComputeSwitchScore(
-		const AActor* Target,
-		const APawn* Pawn, APlayerController* PC,
+	TargetSystemCore::FScoreParams GetScoreParams() const;
+
+	void BuildScoreBatch(
+		FTargetLockScoreBatch& Batch,
+		const TArray<FTargetingDefaultResultData>& TargetResults,
+		const APawn* Pawn, const FTargetSystemViewSnapshot& View,
 		const UTargetLockContext* TargetLockContext
 	) const;
+
+protected:
+	float ComputeLockOnScore(const FTargetLockTargetData& Data, const FTargetSystemViewSnapshot& View) const;
+	float ComputeSwitchScore(const FTargetLockTargetData& Data, const FTargetSystemViewSnapshot& View, ETargetSwitchMode Mode) const;
 };
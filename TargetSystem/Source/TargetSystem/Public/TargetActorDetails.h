@@ -22,4 +22,7 @@ struct FTargetActorDetails
     TArray<UBTargetPoint*> TargetPoints{};
 
     bool bIsTargetable = false;
+
+    // Index of StartTargetPointName in the sorted TargetPoints, resolved once in UTargetSystemDependencies::SetUp
+    int32 StartTargetPointIndex = 0;
 };
@@ -3,11 +3,18 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "TargetSystemCore.h"
 #include "TargetSystemInterface.h"
+#include "TargetSystemViewSnapshot.h"
+#include "TargetSystemVisibilityCache.h"
 #include "Components/ActorComponent.h"
+#include "Engine/LatentActionManager.h"
+#include "WorldCollision.h"
 #include "TargetSystemComponent.generated.h"
 
 struct FTargetActorDetails;
+class UTargetSystemDependencies;
+enum class ETargetInvalidationReason : uint8;
 using TargetInterface = TScriptInterface<ITargetSystemInterface>;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnFinishTargetLock);
@@ -27,6 +34,16 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(
     FRotator&, ControlRotation
 );
 
+/** Result of UTargetSystemComponent::TryStartTargetLockAsync, the locked target or null if the lock failed */
+DECLARE_DELEGATE_OneParam(FOnTargetLockResult, AActor* /* Target */);
+
+UENUM(BlueprintType)
+enum class ETargetLockAsyncResult : uint8
+{
+    Locked,
+    Failed,
+};
+
 UENUM(BlueprintType)
 enum class ECharacterRotationMode : uint8
 {
@@ -34,6 +51,15 @@ enum class ECharacterRotationMode : uint8
     Strafe,
 };
 
+UENUM(BlueprintType)
+enum class ETargetVisibilityTraceMode : uint8
+{
+    // Candidates are traced one by one on the game thread, the lock or switch happens in the same frame
+    Synchronous,
+    // All candidate traces are batched with AsyncLineTraceByChannel, the lock or switch finishes next frame
+    Asynchronous,
+};
+
 class UUserWidget;
 class UWidgetComponent;
 class APlayerController;
@@ -51,6 +77,16 @@ public:
         bool bAdjustPitchBasedOnDistanceToTargetUsingCurve
     );
 
+    // Setters of the options the selection and pitch policies depend on, they pick the policies again
+    UFUNCTION(BlueprintSetter)
+    void SetIgnoreViewport(bool bValue);
+
+    UFUNCTION(BlueprintSetter)
+    void SetAdjustPitchBasedOnDistanceToTarget(bool bValue);
+
+    UFUNCTION(BlueprintSetter)
+    void SetAdjustPitchBasedOnDistanceToTargetUsingCurve(bool bValue);
+
     UPROPERTY(BlueprintAssignable, Category = "Target System | Delegates")
     FOnFinishTargetLock OnFinishTargetLock;
 
@@ -72,6 +108,21 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Target System")
     virtual void TryStartTargetLock();
 
+    /**
+     * TryStartTargetLock that calls OnResult on the game thread once the lock started or failed, however many
+     * frames its queries take and whether it goes through the targeting subsystem or not.
+     * @return handle for CancelTargetLockAsync
+     */
+    FDelegateHandle TryStartTargetLockAsync(FOnTargetLockResult OnResult);
+
+    /** Drops the callback of a TryStartTargetLockAsync call, the lock attempt itself goes on */
+    void CancelTargetLockAsync(FDelegateHandle Handle);
+
+    /** Starts a target lock and continues on Locked or Failed once it resolved */
+    UFUNCTION(BlueprintCallable, Category = "Target System",
+        meta = (Latent, LatentInfo = "LatentInfo", ExpandEnumAsExecs = "Result", DisplayName = "Try Start Target Lock (Async)"))
+    void TryStartTargetLockLatent(ETargetLockAsyncResult& Result, AActor*& Target, FLatentActionInfo LatentInfo);
+
     UFUNCTION(BlueprintCallable, Category = "Target System")
     virtual void StopObservingTarget(const bool bIgnoreAutoSwitch = false, const bool bTargetIsDead = false);
 
@@ -81,10 +132,22 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Target System")
     virtual void SwitchTarget(FVector2D AxisValue);
 
+    UFUNCTION(BlueprintCallable, Category = "Target System | Optimization")
+    int32 GetLineOfSightCacheHits() const { return VisibilityCache.GetHits(); }
+
+    UFUNCTION(BlueprintCallable, Category = "Target System | Optimization")
+    int32 GetLineOfSightCacheMisses() const { return VisibilityCache.GetMisses(); }
+
+    UFUNCTION(BlueprintCallable, Category = "Target System | Optimization")
+    void ResetLineOfSightCacheCounters() { VisibilityCache.ResetCounters(); }
+
 protected:
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+#if WITH_EDITOR
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
 
     // Base params
     UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, Category = "Target System")
@@ -93,7 +156,9 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
     ECharacterRotationMode CharacterRotationMode = ECharacterRotationMode::OrientToMovement;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
+    // Baked into the selection and pitch policies with the two bAdjustPitch options: subclasses must change them
+    // through their setters, a direct write leaves the policies of the old values in place
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, BlueprintSetter = SetIgnoreViewport, Category = "Target System")
 	bool bIgnoreViewport = false;
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System")
@@ -109,9 +174,47 @@ protected:
     float BreakLineOfSightDelay = 2.0f;
 
     // Optimization
+    // Interval of the lock checks, and the fixed-rate baseline of the adaptive interval
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Optimization")
     float TimerTick = 0.5f;
 
+    // Check the lock more often near LoseTargetDistance or after line of sight changes, and rarely while it is clearly safe.
+    // Opt-in, as a safe lock may then take up to MaxLockCheckInterval to notice a lost line of sight
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Optimization")
+    bool bUseAdaptiveLockCheckInterval = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Optimization", meta = (EditCondition = "bUseAdaptiveLockCheckInterval", ClampMin = "0.01"))
+    float MinLockCheckInterval = 0.1f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Optimization", meta = (EditCondition = "bUseAdaptiveLockCheckInterval", ClampMin = "0.01"))
+    float MaxLockCheckInterval = 2.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Optimization")
+    ETargetVisibilityTraceMode VisibilityTraceMode = ETargetVisibilityTraceMode::Synchronous;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Optimization")
+    bool bUseLineOfSightCache = true;
+
+    // Cached line of sight is traced again once the owner or the target moved further than this
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Optimization", meta = (EditCondition = "bUseLineOfSightCache", ClampMin = "0.0"))
+    float LineOfSightCacheInvalidationDistance = 25.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Optimization", meta = (EditCondition = "bUseLineOfSightCache", ClampMin = "0.0"))
+    float LineOfSightCacheMaxAge = 1.0f;
+
+    // Distance and line of sight of the locked target are only checked again once the owner or the target moved this far, 0 checks every TimerTick
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Optimization", meta = (ClampMin = "0.0"))
+    float LockRecheckDistance = 50.0f;
+
+    // Keep the switch target of every input direction up to date while locked, so a switch does not wait for a full search.
+    // Off by default: the search runs every frame while locked, whether the player switches or not
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Optimization")
+    bool bPrecomputeSwitchTargets = false;
+
+    // Potential targets evaluated per frame by the background switch search
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Optimization", meta = (EditCondition = "bPrecomputeSwitchTargets", ClampMin = "1"))
+    int32 SwitchCandidatesPerFrame = 4;
+
     // Distance Settings
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Distance Settings")
     float DangerousDistanceToTarget = 200.0f;
@@ -145,14 +248,14 @@ protected:
 	FVector LockedOnWidgetRelativeLocation = FVector(0.0f, 0.0f, 0.0f);
 
     // Pitch Offset using Curve
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Pitch Offset using Curve")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, BlueprintSetter = SetAdjustPitchBasedOnDistanceToTargetUsingCurve, Category = "Target System | Pitch Offset using Curve")
 	bool bAdjustPitchBasedOnDistanceToTargetUsingCurve = false;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Pitch Offset using Curve")
 	UCurveFloat* DefaultPitchOffsetCurve = nullptr;
 
     // Pitch Offset
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Pitch Offset")
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, BlueprintSetter = SetAdjustPitchBasedOnDistanceToTarget, Category = "Target System | Pitch Offset")
 	bool bAdjustPitchBasedOnDistanceToTarget = true;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Target System | Pitch Offset")
@@ -181,11 +284,20 @@ protected:
 
 protected:
 	void StartObservingTarget();
-	void MessageFinishTargetLock() const;
+	void MessageFinishTargetLock();
 	virtual void AutoSwitchTarget();
 	bool CanSwitchTarget(const FVector2D& AxisValue) const;
 	void ResetIsSwitchingTarget();
 
+	/** Advances the background switch search by a few candidates, called every frame while locked */
+	virtual void UpdateSwitchSlots();
+	virtual void ResetSwitchSlots();
+	virtual TargetInterface FindPrecomputedSwitchTarget(const FVector2D& AxisValue);
+	bool TrySwitchToPrecomputedTarget(const FVector2D& AxisValue);
+	bool IsValidSwitchTarget(const TargetInterface& Interface, const FVector2D& AxisValue) const;
+	bool ObjectIsTargetable(const TargetInterface Interface) const;
+	void SwitchToTarget(const TargetInterface& NewTarget);
+
 private:
 	UPROPERTY()
 	AActor* OwnerActor = nullptr;
@@ -196,25 +308,88 @@ private:
 	UPROPERTY()
 	APlayerController* OwnerPlayerController = nullptr;
 
+	// Created once and re-attached to the locked target point, hidden while not locked
 	UPROPERTY()
 	UWidgetComponent* TargetLockedOnWidgetComponent = nullptr;
 	
 	bool bTargetLocked = false;
 
-    FTimerHandle SwitchingTargetTimerHandle;
-    FTimerHandle ObservingTimer;
-    FTimerHandle BehindWallTimer;
+    // Index into the locked target's TargetPoints, CurrentSocketOnNearestTarget only mirrors it for Blueprints
+    int32 CurrentTargetPointIndex = INDEX_NONE;
+
+    // Locked target's dependencies, which push targetability changes, death and EndPlay
+    TWeakObjectPtr<UTargetSystemDependencies> ObservedDependencies;
+    FDelegateHandle TargetInvalidatedHandle;
+
+    // Locations of the last distance and line of sight check of the locked target
+    FVector LastCheckedOwnerLocation = FVector::ZeroVector;
+    FVector LastCheckedTargetLocation = FVector::ZeroVector;
+    bool bLockCheckPending = true;
+
+    float LastLockCheckTime = 0.f;
+    float LastVisibilityChangeTime = -1.f;
+    bool bLastLineOfSight = true;
+
+    // World times checked by UTargetSystemManager, 0 when not pending
+    double SwitchCooldownEndTime = 0.0;
+    double NextLockCheckTime = 0.0;
+    double BreakLineOfSightTime = 0.0;
+
+    friend class UTargetSystemManager;
+    bool bTickedByManager = false;
+
+    /** Called by UTargetSystemManager every frame while active, returns false once there is nothing left to update */
+    bool TickTargetSystem(float DeltaTime);
+    void RequestManagerTick();
+
+    enum class EVisibilityQueryType : uint8
+    {
+        None,
+        Lock,
+        Switch,
+    };
+
+    struct FVisibilityQuery
+    {
+        EVisibilityQueryType Type = EVisibilityQueryType::None;
+        FVector2D AxisValue = FVector2D::ZeroVector;
+        TArray<TWeakObjectPtr<UObject>> Targets;
+        TArray<FTraceHandle> TraceHandles;
+        FVector Start = FVector::ZeroVector;
+        TMap<const UObject*, bool> Results;
+        int32 PendingTraces = 0;
+    };
+
+    FVisibilityQuery VisibilityQuery;
+    const TMap<const UObject*, bool>* ResolvedVisibility = nullptr;
+
+    mutable FTargetSystemVisibilityCache VisibilityCache;
+
+    // Captured at the start of each lock or switch query
+    FTargetSystemViewSnapshot ViewSnapshot;
+
+    TArray<TargetSystemCore::FTargetCandidate> CandidateScratch;
+    TArray<TargetSystemCore::FSwitchCandidate> SwitchCandidateScratch;
+
+    // Target locations snapshotted on the game thread for the parallel evaluation of large candidate sets
+    TArray<FVector> CandidateLocationScratch;
+    TArray<TargetSystemCore::FSwitchCandidate> SwitchEvaluationScratch;
+    TArray<bool> CandidateInViewportScratch;
+
+    // Background switch search, SwitchSlotTargets holds the result of the last complete pass over PotentialTargets
+    TargetSystemCore::FSwitchSlots SwitchSlotsInProgress;
+    TWeakObjectPtr<UObject> SwitchSlotTargets[TargetSystemCore::NumSwitchSlots];
+    int32 SwitchSweepIndex = 0;
+    float SwitchSweepTargetDistance = 0.f;
 
     bool CanTargetLock() const;
     bool IsInViewport(TargetInterface TargetActor) const;
-    bool ObjectIsTargetable(const TargetInterface Interface) const;
 
-    int32 GetPointIndexByName(const FString& Name) const;
     float GetDistanceFromTarget(const TargetInterface& Interface) const;
     float GetAngleUsingCameraRotation(const FVector& Location) const;
-    float GetAngleUsingCharacterRotation(const FVector& Location) const;
-    FRotator GetControlRotationOnTarget(TargetInterface Interface) const;
-    FTargetActorDetails GetTargetDetails(const TargetInterface& Interface) const;
+    void CaptureViewSnapshot();
+    FRotator GetControlRotationOnTarget(const TargetInterface& Interface) const;
+    const FTargetActorDetails& GetTargetDetails(const TargetInterface& Interface) const;
     FVector GetTargetOwnerLocation(const TargetInterface& Interface) const;
 
     void SetControlRotationOnTarget() const;
@@ -222,18 +397,72 @@ private:
 
     void AddPotentialTargetsByInterface(const TSubclassOf<AActor>& ActorClass);
     bool LineTrace(const FVector& Start, const FVector& End, FHitResult& Hit) const;
-	void CreateAndAttachTargetLockedOnWidgetComponent(const TargetInterface Interface);
+    bool HasLineOfSight(const TargetInterface& Interface) const;
+    bool FindCachedLineOfSight(const UObject* Target, const FVector& Start, const FVector& End, bool& bOutVisible) const;
+    void CacheLineOfSight(const UObject* Target, const FVector& Start, const FVector& End, bool bVisible) const;
+    FCollisionQueryParams MakeTraceQueryParams() const;
+    static bool IsTraceHitOnTarget(const FHitResult& Hit, const FVector& End);
+
+    void StartVisibilityQuery(EVisibilityQueryType Type, const FVector2D& AxisValue = FVector2D::ZeroVector);
+    void OnVisibilityTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+    void FinishVisibilityQuery();
+    void CancelVisibilityQuery();
+
+    // Lock or auto switch query waiting for UTargetSystemManager's frame budget, at most one per component
+    using FTargetQuery = void (UTargetSystemComponent::*)();
+    FTargetQuery PendingTargetQuery = nullptr;
+
+    void RequestTargetQuery(FTargetQuery Query, bool bIsLockQuery);
+    void RunPendingTargetQuery();
+    void CancelPendingTargetQuery();
+
+    void FinishTryStartTargetLock();
+
+    // Callbacks of TryStartTargetLockAsync, resolved by the next lock or lock failure
+    struct FPendingLockResult
+    {
+        FDelegateHandle Handle;
+        FOnTargetLockResult OnResult;
+    };
+    TArray<FPendingLockResult, TInlineAllocator<1>> PendingLockResults;
+
+    void ResolvePendingLockResults(AActor* Target);
+    void FinishAutoSwitchTarget();
+    void FinishSwitchTarget(const FVector2D& AxisValue);
+	UWidgetComponent* GetOrCreateTargetLockedOnWidgetComponent();
+	void AttachTargetLockedOnWidgetComponent(const TargetInterface& Interface);
+	void HideTargetLockedOnWidgetComponent();
 
     
     void UpdateTargetInfo();
+    bool CheckLockedTarget();
+    void ScheduleLockCheck();
+    float GetLockCheckInterval() const;
+    bool ShouldRecheckLock();
+    void BindTargetInvalidation();
+    void UnbindTargetInvalidation();
+    void OnTargetInvalidated(UTargetSystemDependencies* Dependencies, ETargetInvalidationReason Reason);
     bool TrySwitchBetweenTargetPoints(FVector2D AxisValue);
     void StopTargetLock();
 
-    void SortPotentialTargetsByDistance(TArray<TScriptInterface<ITargetSystemInterface>>& Array);
-    void SortPotentialTargetsByAngle(TArray<TScriptInterface<ITargetSystemInterface>>& Array);
-
     TargetInterface FindNearestTarget(bool bUseAngle = false);
-    TargetInterface FindByHorizontal(TArray<TargetInterface> LookTargets, float AxisValue) const;
-    TargetInterface FindByVertical(TArray<TargetInterface> LookTargets, FVector2D AxisValue) const;
-    static FRotator FindLookAtRotation(const FVector Start, const FVector Target);
+    TargetInterface FindSwitchTarget(const FVector2D& AxisValue);
+    void GatherSwitchCandidatesInParallel(const AActor* CurrentTargetActor);
+    bool MakeSwitchCandidate(const TargetInterface& Interface, int32 Index, const AActor* CurrentTargetActor, TargetSystemCore::FSwitchCandidate& OutCandidate) const;
+
+    // Selection and pitch loops instantiated per policy, picked on BeginPlay and by the setters of the options they depend on
+    using FFindNearestTargetIndex = int32 (UTargetSystemComponent::*)(TArray<TargetSystemCore::FTargetCandidate>&, const TargetSystemCore::FNearestTargetParams&);
+    using FGetTargetRotation = FRotator (UTargetSystemComponent::*)(const TargetInterface&, const FRotator&, double) const;
+
+    // Indexed by bUseAngle
+    FFindNearestTargetIndex FindNearestTargetIndexFuncs[2] = {};
+    FGetTargetRotation GetTargetRotationFunc = nullptr;
+
+    void UpdatePolicies();
+
+    template <TargetSystemCore::ENearestTargetPolicy Policy>
+    int32 FindNearestTargetIndex(TArray<TargetSystemCore::FTargetCandidate>& Candidates, const TargetSystemCore::FNearestTargetParams& Params);
+
+    template <TargetSystemCore::ETargetPitchMode PitchMode>
+    FRotator GetTargetRotation(const TargetInterface& Interface, const FRotator& LookRotation, double Roll) const;
 };
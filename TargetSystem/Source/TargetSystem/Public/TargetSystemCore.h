@@ -0,0 +1,361 @@
+// Copyright (c) 2024 NextGenium
+
+#pragma once
+
+// Target selection math shared by UTargetSystemComponent and the targeting tasks.
+// Only depends on the standard library so it can be compiled, tested and benchmarked without the engine,
+// the UE classes gather positions, distances and visibility and forward them here.
+
+#include <algorithm>
+#include <cmath>
+
+namespace TargetSystemCore
+{
+	/** Potential target of a lock, Index refers to the caller's own target list */
+	struct FTargetCandidate
+	{
+		int Index = -1;
+		float Distance = 0.f;
+	};
+
+	/** Potential target of a switch, relative to the player and to the currently locked target */
+	struct FSwitchCandidate
+	{
+		int Index = -1;
+		float Angle = 0.f;
+		float Distance = 0.f;
+		float DistanceToCurrentTarget = 0.f;
+	};
+
+	/** Input directions FindSwitchTarget distinguishes, nearer and farther are taken on the side of AxisX */
+	enum ESwitchSlot
+	{
+		SwitchSlot_Left,
+		SwitchSlot_Right,
+		SwitchSlot_LeftNearer,
+		SwitchSlot_LeftFarther,
+		SwitchSlot_RightNearer,
+		SwitchSlot_RightFarther,
+		NumSwitchSlots
+	};
+
+	/** Best switch candidate of every slot, Index is -1 for empty slots */
+	struct FSwitchSlots
+	{
+		int Index[NumSwitchSlots];
+		float DistanceToCurrentTarget[NumSwitchSlots];
+
+		FSwitchSlots() { Reset(); }
+
+		void Reset()
+		{
+			for (int Slot = 0; Slot < NumSwitchSlots; ++Slot)
+			{
+				Index[Slot] = -1;
+				DistanceToCurrentTarget[Slot] = 0.f;
+			}
+		}
+	};
+
+	/** Selection rule of FindNearestTarget, each one gets its own instantiation of the search loops */
+	enum ENearestTargetPolicy
+	{
+		// Nearest candidate with line of sight, on screen or not
+		NearestPolicy_DistanceOnly,
+		// Nearest candidate with line of sight, off screen ones only within DangerousDistance
+		NearestPolicy_ScreenWeighted,
+		// As ScreenWeighted, then the one closest to the view direction within ExtraDistanceByAngle of the nearest
+		NearestPolicy_DistanceAngle,
+	};
+
+	/** How the pitch of the control rotation follows a locked target */
+	enum ETargetPitchMode
+	{
+		PitchMode_None,
+		PitchMode_Linear,
+		PitchMode_Curve,
+	};
+
+	inline ETargetPitchMode GetTargetPitchMode(const bool bAdjustPitch, const bool bAdjustPitchUsingCurve)
+	{
+		if (bAdjustPitchUsingCurve) return PitchMode_Curve;
+		return bAdjustPitch ? PitchMode_Linear : PitchMode_None;
+	}
+
+	struct FNearestTargetParams
+	{
+		float MaximumDistance = 0.f;
+		float DangerousDistance = 0.f;
+		float MaximumAngle = 0.f;
+		float ExtraDistanceByAngle = 0.f;
+	};
+
+	struct FLockCheckIntervalParams
+	{
+		float MinInterval = 0.1f;
+		float MaxInterval = 2.f;
+		// Fraction of the time the target needs to get out of range that may pass before the next check
+		float SafetyFactor = 0.5f;
+	};
+
+	struct FScoreParams
+	{
+		float ScreenWeight = 1.f;
+		float DistanceWeight = 1.f;
+		float DistanceScale = 0.f;
+		float ScreenOffsetScale = 0.f;
+	};
+
+	/**
+	 * Angle in degrees between the view yaw and the direction to a target, offset by 360 when negative.
+	 * Left of the view is (0, 180), right of the view is (180, 360).
+	 */
+	inline float GetYawAngle(const double ViewYaw, const double ToTargetX, const double ToTargetY)
+	{
+		constexpr double RadToDeg = 180.0 / 3.1415926535897932;
+		const double LookAtYaw = std::atan2(ToTargetY, ToTargetX) * RadToDeg;
+
+		double YawAngle = ViewYaw - LookAtYaw;
+		if (YawAngle < 0.0)
+		{
+			YawAngle += 360.0;
+		}
+		return static_cast<float>(YawAngle);
+	}
+
+	/**
+	 * Picks the target to lock on among Candidates, which are reordered in place.
+	 * The nearest selectable candidate wins, unless Policy is NearestPolicy_DistanceAngle and another selectable
+	 * candidate within ExtraDistanceByAngle of it is closer to the view direction.
+	 * IsInViewport(Index), HasLineOfSight(Index) and GetAngle(Index) are only called for the candidates needed to settle
+	 * the result, nearest first.
+	 * @return Index of the chosen candidate, -1 if none is selectable
+	 */
+	template <ENearestTargetPolicy Policy, typename FIsInViewport, typename FHasLineOfSight, typename FGetAngle>
+	int FindNearestTargetWithPolicy(
+		FTargetCandidate* Candidates, int NumCandidates, const FNearestTargetParams& Params,
+		FIsInViewport&& IsInViewport, FHasLineOfSight&& HasLineOfSight, FGetAngle&& GetAngle)
+	{
+		constexpr bool bCheckViewport = Policy != NearestPolicy_DistanceOnly;
+		constexpr bool bUseAngle = Policy == NearestPolicy_DistanceAngle;
+
+		NumCandidates = static_cast<int>(std::remove_if(Candidates, Candidates + NumCandidates,
+			[&Params](const FTargetCandidate& Candidate) { return Candidate.Distance > Params.MaximumDistance; }) - Candidates);
+
+		// Heap ordered nearest first, so the list is never fully sorted
+		const auto FartherFirst = [](const FTargetCandidate& A, const FTargetCandidate& B) { return A.Distance > B.Distance; };
+		std::make_heap(Candidates, Candidates + NumCandidates, FartherFirst);
+
+		const auto PopNearest = [&]() -> const FTargetCandidate&
+		{
+			std::pop_heap(Candidates, Candidates + NumCandidates, FartherFirst);
+			return Candidates[--NumCandidates];
+		};
+
+		const auto IsSelectable = [&](const FTargetCandidate& Candidate)
+		{
+			if constexpr (bCheckViewport)
+			{
+				if (Candidate.Distance > Params.DangerousDistance && !IsInViewport(Candidate.Index)) return false;
+			}
+			return static_cast<bool>(HasLineOfSight(Candidate.Index));
+		};
+
+		FTargetCandidate Nearest;
+		bool bFoundNearest = false;
+		while (NumCandidates > 0)
+		{
+			Nearest = PopNearest();
+			if (!IsSelectable(Nearest)) continue;
+
+			bFoundNearest = true;
+			break;
+		}
+		if (!bFoundNearest) return -1;
+		if constexpr (!bUseAngle) return Nearest.Index;
+
+		// Smallest angle among the remaining candidates close enough to the nearest one
+		const float MaxDistanceByAngle = Nearest.Distance + Params.ExtraDistanceByAngle;
+		int BestByAngleIndex = -1;
+		float BestAngle = Params.MaximumAngle;
+
+		const float NearestAngle = GetAngle(Nearest.Index);
+		if (NearestAngle <= BestAngle)
+		{
+			BestByAngleIndex = Nearest.Index;
+			BestAngle = NearestAngle;
+		}
+
+		while (NumCandidates > 0)
+		{
+			const FTargetCandidate Candidate = PopNearest();
+			if (Candidate.Distance > MaxDistanceByAngle) break;
+
+			const float Angle = GetAngle(Candidate.Index);
+			if (Angle > Params.MaximumAngle) continue;
+			if (BestByAngleIndex != -1 && Angle >= BestAngle) continue;
+			if (!IsSelectable(Candidate)) continue;
+
+			BestByAngleIndex = Candidate.Index;
+			BestAngle = Angle;
+		}
+
+		return BestByAngleIndex != -1 ? BestByAngleIndex : Nearest.Index;
+	}
+
+	/**
+	 * Picks the switch target on the side given by AxisX, the one nearest to the current target wins.
+	 * When AxisY dominates, AxisY < 0 only accepts targets farther than the current one and AxisY >= 0 only nearer ones.
+	 * @return Index of the chosen candidate, -1 if none qualifies
+	 */
+	inline int FindSwitchTarget(
+		const FSwitchCandidate* Candidates, const int NumCandidates,
+		const float AxisX, const float AxisY, const float MaximumDistance, const float CurrentTargetDistance)
+	{
+		const bool bHorizontal = std::abs(AxisX) > std::abs(AxisY);
+		const float RangeMin = AxisX < 0.f ? 0.f : 180.f;
+		const float RangeMax = AxisX < 0.f ? 180.f : 360.f;
+
+		int BestIndex = -1;
+		float MinDistance = MaximumDistance;
+		for (int i = 0; i < NumCandidates; ++i)
+		{
+			const FSwitchCandidate& Candidate = Candidates[i];
+			if (Candidate.Angle < RangeMin || Candidate.Angle > RangeMax) continue;
+			if (Candidate.Distance > MaximumDistance) continue;
+			if (Candidate.DistanceToCurrentTarget > MinDistance) continue;
+
+			if (!bHorizontal)
+			{
+				if (AxisY < 0.f && Candidate.Distance < CurrentTargetDistance) continue;
+				if (AxisY >= 0.f && Candidate.Distance > CurrentTargetDistance) continue;
+			}
+
+			MinDistance = Candidate.DistanceToCurrentTarget;
+			BestIndex = Candidate.Index;
+		}
+		return BestIndex;
+	}
+
+	/** Slot FindSwitchTarget would search for this input */
+	inline int GetSwitchSlot(const float AxisX, const float AxisY)
+	{
+		const bool bLeft = AxisX < 0.f;
+		if (std::abs(AxisX) > std::abs(AxisY)) return bLeft ? SwitchSlot_Left : SwitchSlot_Right;
+		if (AxisY < 0.f) return bLeft ? SwitchSlot_LeftFarther : SwitchSlot_RightFarther;
+		return bLeft ? SwitchSlot_LeftNearer : SwitchSlot_RightNearer;
+	}
+
+	/**
+	 * Offers Candidate to every slot it qualifies for, keeping the one FindSwitchTarget would pick for that input.
+	 * Adding candidates one at a time lets the search be spread over several frames.
+	 */
+	inline void AddSwitchCandidate(
+		FSwitchSlots& Slots, const FSwitchCandidate& Candidate, const float MaximumDistance, const float CurrentTargetDistance)
+	{
+		if (Candidate.Distance > MaximumDistance) return;
+
+		const auto Offer = [&Slots, &Candidate, MaximumDistance](const int Slot)
+		{
+			const float MinDistance = Slots.Index[Slot] != -1 ? Slots.DistanceToCurrentTarget[Slot] : MaximumDistance;
+			if (Candidate.DistanceToCurrentTarget > MinDistance) return;
+
+			Slots.Index[Slot] = Candidate.Index;
+			Slots.DistanceToCurrentTarget[Slot] = Candidate.DistanceToCurrentTarget;
+		};
+
+		const bool bNearer = Candidate.Distance <= CurrentTargetDistance;
+		const bool bFarther = Candidate.Distance >= CurrentTargetDistance;
+		if (Candidate.Angle >= 0.f && Candidate.Angle <= 180.f)
+		{
+			Offer(SwitchSlot_Left);
+			if (bNearer) Offer(SwitchSlot_LeftNearer);
+			if (bFarther) Offer(SwitchSlot_LeftFarther);
+		}
+		if (Candidate.Angle >= 180.f && Candidate.Angle <= 360.f)
+		{
+			Offer(SwitchSlot_Right);
+			if (bNearer) Offer(SwitchSlot_RightNearer);
+			if (bFarther) Offer(SwitchSlot_RightFarther);
+		}
+	}
+
+	/**
+	 * Index of the target point to switch to from CurrentIndex. The input direction is mirrored when the player is
+	 * behind the target, so pushing right always moves the lock to the right on screen.
+	 * @return New index, -1 if the switch would leave [0, NumPoints)
+	 */
+	inline int GetTargetPointSwitchIndex(
+		const int CurrentIndex, const int NumPoints,
+		const float AxisX, const float AxisY, const double PlayerYaw, const double TargetYaw)
+	{
+		const float MajorAxis = std::abs(AxisX) > std::abs(AxisY) ? AxisX : AxisY;
+		const bool bFacingSameWay = PlayerYaw > TargetYaw - 90.0 && PlayerYaw < TargetYaw + 90.0;
+		const int SwitchDirection = bFacingSameWay == (MajorAxis > 0.f) ? 1 : -1;
+
+		const int NewIndex = CurrentIndex + SwitchDirection;
+		return NewIndex >= 0 && NewIndex < NumPoints ? NewIndex : -1;
+	}
+
+	/** Pitch offset applied on top of the look at pitch, linear in the distance to the target */
+	inline float GetLinearPitchOffset(
+		const float Distance, const float Coefficient, const float Offset, const float PitchMin, const float PitchMax)
+	{
+		const float PitchInRange = (Distance * Coefficient + Offset) * -1.f;
+		return PitchInRange < PitchMin ? PitchMin : PitchInRange < PitchMax ? PitchInRange : PitchMax;
+	}
+
+	/**
+	 * Delay until the next check of a lock. It is short near LoseTargetDistance or right after the line of sight
+	 * changed, and it grows with the time the target needs to get out of range at its current separation speed.
+	 * @param DistanceMargin LoseTargetDistance minus the current distance
+	 * @param SeparationSpeed Speed at which the player and the target move apart, negative when closing in
+	 */
+	inline float GetLockCheckInterval(
+		const float DistanceMargin, const float SeparationSpeed, const bool bVisibilityUnstable, const FLockCheckIntervalParams& Params)
+	{
+		if (bVisibilityUnstable || DistanceMargin <= 0.f) return Params.MinInterval;
+		if (SeparationSpeed <= 0.f) return Params.MaxInterval;
+
+		const float Interval = DistanceMargin / SeparationSpeed * Params.SafetyFactor;
+		return Interval < Params.MinInterval ? Params.MinInterval : Interval < Params.MaxInterval ? Interval : Params.MaxInterval;
+	}
+
+	/** Lock-on score, lower is better: screen distance to ScreenCenter plus world distance to the player */
+	inline float ComputeLockOnScore(
+		const float Distance, const float ScreenX, const float ScreenY, const float CenterX, const float CenterY,
+		const FScoreParams& Params)
+	{
+		const float DistanceScore = Params.DistanceScale > 0.f ? Distance / Params.DistanceScale : Distance;
+
+		const float DeltaX = ScreenX - CenterX;
+		const float DeltaY = ScreenY - CenterY;
+		const float PixelOffset = std::sqrt(DeltaX * DeltaX + DeltaY * DeltaY);
+		const float ScreenScore = Params.ScreenOffsetScale > 0.f ? PixelOffset / Params.ScreenOffsetScale : PixelOffset;
+
+		return ScreenScore * Params.ScreenWeight + DistanceScore * Params.DistanceWeight;
+	}
+
+	/** Horizontal screen position switch scores are measured from, shifted towards the input direction */
+	inline float GetSwitchCenterX(const float ViewportCenterX, const bool bSwitchLeft, const float ScreenOffsetScale)
+	{
+		return ViewportCenterX + (bSwitchLeft ? -1.f : 1.f) * (ScreenOffsetScale * 0.5f);
+	}
+
+	/** Switch score, lower is better: horizontal screen distance to the switch center plus world distance to the player */
+	inline float ComputeSwitchScore(const float Distance, const float ScreenX, const float SwitchCenterX, const FScoreParams& Params)
+	{
+		const float DistanceScore = Params.DistanceScale > 0.f ? Distance / Params.DistanceScale : Distance;
+
+		const float ScreenDelta = std::abs(ScreenX - SwitchCenterX);
+		const float ScreenScore = Params.ScreenOffsetScale > 0.f ? ScreenDelta / Params.ScreenOffsetScale : ScreenDelta;
+
+		return ScreenScore * Params.ScreenWeight + DistanceScore * Params.DistanceWeight;
+	}
+
+	/** True when a target is on the opposite side of the screen to the switch input */
+	inline bool IsOppositeToSwitch(const float ScreenX, const float ViewportCenterX, const bool bSwitchLeft)
+	{
+		return (ScreenX - ViewportCenterX) * (bSwitchLeft ? -1.f : 1.f) < 0.f;
+	}
+}
@@ -7,18 +7,40 @@
 #include "UObject/Object.h"
 #include "TargetSystemDependencies.generated.h"
 
+UENUM(BlueprintType)
+enum class ETargetInvalidationReason : uint8
+{
+    NotTargetable,
+    Died,
+    EndPlay,
+};
+
+class UTargetSystemDependencies;
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnTargetInvalidated, UTargetSystemDependencies*, ETargetInvalidationReason);
+
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class TARGETSYSTEM_API UTargetSystemDependencies final : public UActorComponent
 {
     GENERATED_BODY()
 
 public:
-    FTargetActorDetails GetTargetActorDetails() const { return TargetActorDetails; }
-    void SetIsTargetable(bool Value) {TargetActorDetails.bIsTargetable = Value; }
+    const FTargetActorDetails& GetTargetActorDetails() const { return TargetActorDetails; }
+    void SetIsTargetable(bool Value);
+
+    /** Stops the owner from being targetable and breaks every lock on it right away */
+    UFUNCTION(BlueprintCallable, Category = "Target System")
+    void NotifyDied();
+
+    /** Broadcast when the owner stops being a valid target, locked components listen to it instead of polling */
+    FOnTargetInvalidated OnTargetInvalidated;
 
     void SetUp(TArray<UBTargetPoint*> TargetPoints);
 
 protected:
+    virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Details")
     FTargetActorDetails TargetActorDetails;
 };
@@ -30,4 +30,7 @@ public:
 
     virtual void StartTargetable() {}
     virtual void StopTargetable() {}
+
+    /** Breaks every lock on this target immediately, call it when the implementer dies */
+    void NotifyTargetDied();
 };
@@ -0,0 +1,109 @@
+// Copyright (c) 2024 NextGenium
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TargetSystemManager.generated.h"
+
+class UTargetSystemComponent;
+class UTargetSystemManager;
+
+/** Order in which queries deferred by the frame budget run, higher first */
+enum class ETargetSystemQueryPriority : uint8
+{
+	AutoSwitch,
+	Lock,
+};
+
+/** Runs UTargetSystemManager's batch in TG_PrePhysics, like the component ticks it replaces, so control rotations are set before the camera update */
+USTRUCT()
+struct FTargetSystemManagerTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UTargetSystemManager* Manager = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	virtual FName DiagnosticContext(bool bDetailed) override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FTargetSystemManagerTickFunction> : public TStructOpsTypeTraitsBase2<FTargetSystemManagerTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Ticks every active UTargetSystemComponent of a world in one batch. Components do not tick themselves,
+ * they register here while locked or while a switch cooldown is running and drop out once idle.
+ * Target queries also go through here so they can share a per-frame time budget (TargetSystem.QueryBudgetUs, off by default).
+ */
+UCLASS()
+class TARGETSYSTEM_API UTargetSystemManager : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UTargetSystemManager* Get(const UWorld* World);
+
+	/** True when NumCandidates is large enough to evaluate them with ParallelFor, see TargetSystem.ParallelCandidateThreshold */
+	static bool ShouldEvaluateInParallel(int32 NumCandidates);
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	void Tick(float DeltaTime);
+
+	void RegisterActiveComponent(UTargetSystemComponent* Component);
+	void UnregisterActiveComponent(UTargetSystemComponent* Component);
+
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	int32 GetNumActiveComponents() const { return ActiveComponents.Num(); }
+
+	/**
+	 * Runs Query right away if this frame's budget allows it, otherwise queues it to run in a later frame by priority.
+	 * Query is both the work and its completion, it is dropped if Owner is destroyed first.
+	 * @return true if Query already ran
+	 */
+	bool RunOrQueueQuery(const UObject* Owner, ETargetSystemQueryPriority Priority, FSimpleDelegate Query);
+	void CancelQueries(const UObject* Owner);
+
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	int32 GetNumQueuedQueries() const { return QueuedQueries.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FQueuedQuery
+	{
+		TWeakObjectPtr<const UObject> Owner;
+		ETargetSystemQueryPriority Priority = ETargetSystemQueryPriority::AutoSwitch;
+		uint64 Sequence = 0;
+		FSimpleDelegate Query;
+	};
+
+	static bool IsQueuedBefore(const FQueuedQuery& A, const FQueuedQuery& B);
+	void RunQueuedQueries();
+	void RunQuery(const FSimpleDelegate& Query);
+	void BeginBudgetFrame();
+
+	// Entries unregistered during Tick are only nulled and compacted by the tick loop
+	TArray<TWeakObjectPtr<UTargetSystemComponent>> ActiveComponents;
+
+	FTargetSystemManagerTickFunction TickFunction;
+
+	// Heap ordered by priority, then by request order
+	TArray<FQueuedQuery> QueuedQueries;
+	uint64 NextQuerySequence = 0;
+
+	uint64 BudgetFrame = 0;
+	double BudgetSpentUs = 0.0;
+	int32 QueriesRunThisFrame = 0;
+};
@@ -0,0 +1,48 @@
+// Copyright (c) 2024 NextGenium
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Uniform hash grid over the XY plane. Entries are addressed by a dense index that mirrors the owner's array,
+ * so removal follows RemoveAtSwap semantics: the last entry takes the index of the removed one.
+ */
+class TARGETSYSTEM_API FTargetSystemSpatialGrid
+{
+public:
+	explicit FTargetSystemSpatialGrid(const float InCellSize = 1000.f);
+
+	float GetCellSize() const { return CellSize; }
+	void SetCellSize(const float InCellSize);
+
+	int32 Num() const { return Entries.Num(); }
+
+	/** Appends an entry, its index is Num() - 1 after the call */
+	void Add(const FVector& Location);
+	void RemoveAtSwap(const int32 Index);
+	void Update(const int32 Index, const FVector& Location);
+	void Reset();
+
+	const FVector& GetLocation(const int32 Index) const { return Entries[Index].Location; }
+
+	/** Appends the index of every entry within Radius (3D distance) of Center */
+	void QueryRadius(const FVector& Center, const float Radius, TArray<int32>& OutIndices) const;
+
+private:
+	struct FEntry
+	{
+		FVector Location;
+		FIntPoint Cell;
+	};
+
+	FIntPoint GetCell(const FVector& Location) const;
+	void AddToCell(const FIntPoint& Cell, const int32 Index);
+	void RemoveFromCell(const FIntPoint& Cell, const int32 Index);
+
+	float CellSize = 1000.f;
+	float InvCellSize = 0.001f;
+
+	TArray<FEntry> Entries;
+	TMap<FIntPoint, TArray<int32>> Cells;
+};
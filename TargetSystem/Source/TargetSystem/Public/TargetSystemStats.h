@@ -0,0 +1,67 @@
+// Copyright (c) 2024 NextGenium
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+DECLARE_STATS_GROUP(TEXT("TargetSystem"), STATGROUP_TargetSystem, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("TryStartTargetLock"), STAT_TargetSystem_TryStartTargetLock, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("FindNearestTarget"), STAT_TargetSystem_FindNearestTarget, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GatherPotentialTargets"), STAT_TargetSystem_GatherPotentialTargets, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("LineTrace"), STAT_TargetSystem_LineTrace, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("StartVisibilityQuery"), STAT_TargetSystem_StartVisibilityQuery, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("FinishVisibilityQuery"), STAT_TargetSystem_FinishVisibilityQuery, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SwitchTarget"), STAT_TargetSystem_SwitchTarget, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("UpdateTargetInfo"), STAT_TargetSystem_UpdateTargetInfo, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("UpdateSwitchSlots"), STAT_TargetSystem_UpdateSwitchSlots, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("TickTargetSystem"), STAT_TargetSystem_TickComponent, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SetControlRotationOnTarget"), STAT_TargetSystem_SetControlRotationOnTarget, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Manager Tick"), STAT_TargetSystem_ManagerTick, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Registry Tick"), STAT_TargetSystem_RegistryTick, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Registry Query"), STAT_TargetSystem_RegistryQuery, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Publish Target Snapshot"), STAT_TargetSystem_PublishTargetSnapshot, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Targeting Request"), STAT_TargetSystem_TargetingRequest, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Targeting Completed"), STAT_TargetSystem_TargetingCompleted, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Sort Task Score"), STAT_TargetSystem_SortTaskScore, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Sort Task Build Batch"), STAT_TargetSystem_SortTaskBuildBatch, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Registry Selection Task"), STAT_TargetSystem_RegistrySelectionTask, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Filter And Sort Task"), STAT_TargetSystem_FilterAndSortTask, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Switch Filter Task"), STAT_TargetSystem_SwitchFilterTask, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Active Components"), STAT_TargetSystemActiveComponents, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Query Queue Depth"), STAT_TargetSystemQueryQueueDepth, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Queries Deferred"), STAT_TargetSystemQueriesDeferred, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Precomputed Switches"), STAT_TargetSystemPrecomputedSwitches, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Precomputed Switch Misses"), STAT_TargetSystemPrecomputedSwitchMisses, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Parallel Evaluations"), STAT_TargetSystemParallelEvaluations, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Candidates Considered"), STAT_TargetSystemCandidatesConsidered, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Lock Checks"), STAT_TargetSystemLockChecks, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+/** Lock checks a fixed TimerTick rate would have run minus the adaptive ones, negative while locks sit near their break distance */
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Lock Checks Avoided"), STAT_TargetSystemLockChecksAvoided, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces Issued"), STAT_TargetSystemTracesIssued, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+
+/** Lock-on widget components created this frame, stays at zero while locking and switching reuse the pooled one */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Lock-On Widget Allocations"), STAT_TargetSystemLockOnWidgetAllocations, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Active Targeting Requests"), STAT_TargetSystemActiveTargetingRequests, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Cancelled Targeting Requests"), STAT_TargetSystemCancelledTargetingRequests, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Coalesced Lock Requests"), STAT_TargetSystemCoalescedLockRequests, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+/** Target snapshots allocated this frame, stays at zero unless a task still holds the buffer about to be captured into */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Target Snapshot Allocations"), STAT_TargetSystemTargetSnapshotAllocations, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Lock Context Allocations"), STAT_TargetSystemLockContextAllocations, STATGROUP_TargetSystem, TARGETSYSTEM_API);
+
+/** Insights channel of the target system scopes, enable with -trace=cpu,TargetSystem */
+UE_TRACE_CHANNEL_EXTERN(TargetSystemChannel, TARGETSYSTEM_API);
+
+/** Cycle stat for stat TargetSystem and a CPU event of the same name on the TargetSystem trace channel */
+#define TARGETSYSTEM_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, TargetSystemChannel)
+
+/** Nested CPU event named after Object, so captures separate the cost per component, the name is only built while tracing */
+#define TARGETSYSTEM_TRACE_OBJECT_SCOPE(Object) \
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL( \
+		UE_TRACE_CHANNELEXPR_IS_ENABLED(TargetSystemChannel) ? *GetNameSafe(Object) : TEXT(""), TargetSystemChannel)
@@ -0,0 +1,81 @@
+// Copyright (c) 2024 NextGenium
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TargetSystemSpatialGrid.h"
+#include "TargetSystemTargetSnapshot.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TargetSystemSubsystem.generated.h"
+
+class UTargetSystemDependencies;
+
+/**
+ * Per-world registry of targetable actors. UTargetSystemDependencies registers its owner on BeginPlay and
+ * unregisters it on EndPlay, so candidate gathering only walks actors that can actually be targeted.
+ * Registered owners are kept in a spatial hash grid refreshed once per frame, before the first query, to answer radius
+ * queries. Their positions are captured on demand, at most once per frame, into an immutable snapshot for tasks
+ * running off the game thread.
+ */
+UCLASS(Config = Game)
+class TARGETSYSTEM_API UTargetSystemSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UTargetSystemSubsystem* Get(const UWorld* World);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/** Moves the owners to their current cells, once per frame. UTargetSystemManager calls it before its queries run */
+	void RefreshGrid();
+
+	void RegisterTargetable(UTargetSystemDependencies* Dependencies);
+	void UnregisterTargetable(UTargetSystemDependencies* Dependencies);
+
+	const TArray<TWeakObjectPtr<UTargetSystemDependencies>>& GetTargetables() const { return Targetables; }
+
+	/** Appends every registered targetable whose owner is within Radius of Origin */
+	void QueryTargetablesInRadius(const FVector& Origin, const float Radius, TArray<UTargetSystemDependencies*>& OutTargetables) const;
+
+	/**
+	 * Snapshot of this frame, captured by the first call of the frame. Get it on the game thread and hand it to worker
+	 * tasks, it stays unchanged while referenced as the subsystem double buffers it.
+	 */
+	TSharedRef<const FTargetSystemTargetSnapshot, ESPMode::ThreadSafe> GetTargetSnapshot();
+
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	int32 GetNumTargetables() const { return Targetables.Num(); }
+
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	float GetGridCellSize() const { return Grid.GetCellSize(); }
+
+	UFUNCTION(BlueprintCallable, Category = "Target System")
+	void SetGridCellSize(const float CellSize);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Default cell size of the targetables grid, can be overridden per world with SetGridCellSize */
+	UPROPERTY(Config)
+	float GridCellSize = 1000.f;
+
+private:
+	void RemoveTargetableAt(const int32 Index);
+	void PublishTargetSnapshot();
+
+	TArray<TWeakObjectPtr<UTargetSystemDependencies>> Targetables;
+	TMap<TWeakObjectPtr<UTargetSystemDependencies>, int32> TargetableIndices;
+	FTargetSystemSpatialGrid Grid;
+	uint64 RefreshedGridFrame = MAX_uint64;
+
+	mutable TArray<int32> QueryScratch;
+
+	// The front buffer is read, the back one is captured into and becomes the front, unless a reader still holds it
+	TSharedPtr<FTargetSystemTargetSnapshot, ESPMode::ThreadSafe> TargetSnapshots[2];
+	int32 PublishedTargetSnapshot = 0;
+	uint64 PublishedTargetSnapshotFrame = MAX_uint64;
+};
@@ -0,0 +1,49 @@
+// Copyright (c) 2024 NextGenium
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UTargetSystemDependencies;
+
+/** State of one targetable in FTargetSystemTargetSnapshot */
+struct FTargetSystemTargetState
+{
+	// Identifies the targetable, must not be dereferenced off the game thread
+	const UTargetSystemDependencies* Dependencies = nullptr;
+
+	FVector Location = FVector::ZeroVector;
+
+	// Range of this target's points in FTargetSystemTargetSnapshot::TargetPointLocations
+	int32 FirstTargetPoint = 0;
+	int32 NumTargetPoints = 0;
+
+	bool bCouldBeTarget = false;
+	bool bIsTargetable = false;
+};
+
+/**
+ * Owner and target point locations of every registered targetable for one frame. UTargetSystemSubsystem captures it
+ * at most once per frame, when first asked for it, and never modifies it after publishing, so tasks on other threads
+ * can read it without locking while a later frame's snapshot is captured.
+ */
+struct TARGETSYSTEM_API FTargetSystemTargetSnapshot
+{
+	/** Captures Targetables in place, reusing the allocations of the previous capture */
+	void Capture(uint64 InFrame, const TArray<TWeakObjectPtr<UTargetSystemDependencies>>& Targetables);
+
+	/** Index of Dependencies in Targets, INDEX_NONE if it was not registered when the snapshot was captured */
+	int32 FindTarget(const UTargetSystemDependencies* Dependencies) const;
+
+	TConstArrayView<FVector> GetTargetPointLocations(const FTargetSystemTargetState& Target) const
+	{
+		return MakeArrayView(TargetPointLocations.GetData() + Target.FirstTargetPoint, Target.NumTargetPoints);
+	}
+
+	uint64 Frame = 0;
+	TArray<FTargetSystemTargetState> Targets;
+	TArray<FVector> TargetPointLocations;
+
+private:
+	TMap<const UTargetSystemDependencies*, int32> TargetIndices;
+};
@@ -0,0 +1,45 @@
+// Copyright (c) 2024 NextGenium
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class APlayerController;
+
+/**
+ * Camera and projection state captured once per query, so candidates are projected and measured against the
+ * same view without looking up the camera or the viewport again for every target.
+ */
+struct TARGETSYSTEM_API FTargetSystemViewSnapshot
+{
+	/** Captures the view of ViewOwner's camera (or ViewOwner itself) and PlayerController's local player */
+	static FTargetSystemViewSnapshot Capture(const AActor* ViewOwner, const APlayerController* PlayerController);
+
+	bool IsCaptured() const { return bIsCaptured; }
+	bool HasPlayerController() const { return bHasPlayerController; }
+	bool HasProjection() const { return bHasProjection; }
+
+	/** Same result as APlayerController::ProjectWorldLocationToScreen, OutScreenLocation is zero when it fails */
+	bool ProjectWorldToScreen(const FVector& WorldLocation, FVector2D& OutScreenLocation) const;
+
+	/** Yaw from the camera forward to Location in [0, 360) */
+	float GetYawAngle(const FVector& Location) const;
+
+	bool IsInViewport(const FVector& Location) const;
+
+	const FVector2D& GetViewportSize() const { return ViewportSize; }
+	FVector2D GetViewportCenter() const { return ViewportSize * 0.5f; }
+
+	/** Camera location when the owner has a camera component, owner location otherwise */
+	FVector ViewLocation = FVector::ZeroVector;
+	FRotator ViewRotation = FRotator::ZeroRotator;
+
+	FMatrix ViewProjectionMatrix = FMatrix::Identity;
+	FIntRect ViewRect;
+	FVector2D ViewportSize = FVector2D::ZeroVector;
+
+private:
+	bool bIsCaptured = false;
+	bool bHasPlayerController = false;
+	bool bHasProjection = false;
+};
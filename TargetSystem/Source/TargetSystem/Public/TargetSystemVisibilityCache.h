@@ -0,0 +1,46 @@
+// Copyright (c) 2024 NextGenium
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+/**
+ * Line of sight results keyed by target. An entry is reused until the source or the target has moved further
+ * than the invalidation distance since it was traced, or until it is older than the maximum age.
+ */
+class TARGETSYSTEM_API FTargetSystemVisibilityCache
+{
+public:
+	bool Find(
+		const UObject* Target,
+		const FVector& SourceLocation,
+		const FVector& TargetLocation,
+		const double Now,
+		const double MaxAge,
+		const float InvalidationDistance,
+		bool& bOutVisible
+	);
+
+	void Store(const UObject* Target, const FVector& SourceLocation, const FVector& TargetLocation, const double Now, const bool bVisible);
+	void Remove(const UObject* Target);
+	void RemoveExpired(const double Now, const double MaxAge);
+	void Reset();
+
+	uint32 GetHits() const { return Hits; }
+	uint32 GetMisses() const { return Misses; }
+	void ResetCounters();
+
+private:
+	struct FEntry
+	{
+		FVector SourceLocation;
+		FVector TargetLocation;
+		double Timestamp = 0.0;
+		bool bVisible = false;
+	};
+
+	TMap<TObjectKey<UObject>, FEntry> Entries;
+	uint32 Hits = 0;
+	uint32 Misses = 0;
+};
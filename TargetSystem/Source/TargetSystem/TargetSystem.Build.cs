@@ -43,6 +43,7 @@ public class TargetSystem : ModuleRules
                 "Slate",
 				"SlateCore", 
 				"TargetingSystem", 
+				"AIModule",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);